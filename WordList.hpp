@@ -0,0 +1,196 @@
+// Header-only word list for First.cpp.
+//
+// WordList holds the words and their operations. Words are stored exactly
+// as given, packed into an arena, and compare the way tolower() on a plain
+// char did in First.cpp; the fold table is built by the compiler.
+//
+// new.c and more.c are C programs with their own lists; they share only
+// the search kernels in casesearch.h. The list itself never prints.
+#ifndef WORDLIST_HPP
+#define WORDLIST_HPP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "casesearch.h"
+
+#define MAX_WORD_LEN 256
+#define INITIAL_CAPACITY 10
+#define ARENA_CHUNK_SIZE (1 << 20)
+
+// ASCII case folding; searches use the casesearch.h kernels, which fold the
+// same way
+constexpr unsigned char asciiFold(unsigned char c) {
+    return (unsigned)(c - 'A') < 26u ? (unsigned char)(c + 32) : c;
+}
+
+// 256-entry fold table built by the compiler from asciiFold()
+struct FoldTable {
+    unsigned char folded[256];
+    constexpr FoldTable() : folded() {
+        for (int c = 0; c < 256; c++) {
+            folded[c] = asciiFold((unsigned char)c);
+        }
+    }
+};
+
+constexpr FoldTable foldTable{};
+
+// The order tolower() gives when handed a plain (signed) char, as First.cpp
+// did: glibc maps -128..-2 to their unsigned values, but 0xFF reads as EOF
+constexpr int foldRank(unsigned char folded) {
+    return folded == 0xFF ? -1 : folded;
+}
+
+// Block of memory that word strings are packed into
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t used;
+    size_t capacity;
+} ArenaChunk;
+
+struct WordList {
+    char **words;
+    int size;
+    int capacity;
+    // Words packed back to back into large chunks, released with a handful of frees
+    ArenaChunk *chunks;
+
+    WordList() : words(NULL), size(0), capacity(0), chunks(NULL) {}
+    ~WordList() { clear(); }
+    WordList(const WordList &) = delete;
+    WordList &operator=(const WordList &) = delete;
+
+    // Release every word and go back to an empty list
+    void clear() {
+        releaseChunks();
+        free(words);
+        words = NULL;
+        size = 0;
+        capacity = 0;
+    }
+
+    // Case-insensitive comparison, in the order foldRank() gives bytes
+    static int compare(const char *s1, const char *s2) {
+        const unsigned char *a = (const unsigned char *)s1;
+        const unsigned char *b = (const unsigned char *)s2;
+        while (*a && *b && foldTable.folded[*a] == foldTable.folded[*b]) {
+            a++;
+            b++;
+        }
+        return foldRank(foldTable.folded[*a]) - foldRank(foldTable.folded[*b]);
+    }
+
+    // Case-insensitive substring search
+    static const char *search(const char *haystack, const char *needle) {
+        if (!*needle) return haystack;
+        size_t nlen = strlen(needle);
+        size_t hlen = strlen(haystack);
+        if (hlen < nlen) return NULL;
+        return searchFolded(haystack, hlen, needle, nlen);
+    }
+
+    // Store a copy of word at the end of the list
+    void insert(const char *word) {
+        if (size >= capacity) {
+            capacity = capacity ? capacity * 2 : INITIAL_CAPACITY;
+            words = (char **)realloc(words, capacity * sizeof(char *));
+            if (!words) {
+                fprintf(stderr, "Memory reallocation failed\n");
+                exit(1);
+            }
+        }
+        words[size++] = copyText(word, strlen(word) + 1);
+    }
+
+    // Index of the nth word containing pattern, counting from the front (or
+    // from the back when reverse is set), or -1 if there are fewer
+    int findNth(const char *pattern, int n, bool reverse) const {
+        int count = 0;
+        for (int k = 0; k < size; k++) {
+            int i = reverse ? size - 1 - k : k;
+            if (search(words[i], pattern) && ++count == n) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Fill out with the last n words (n <= size) in reverse alphabetical
+    // order; words that compare equal keep their insertion order
+    void lastReversed(int n, const char **out) const {
+        for (int i = 0; i < n; i++) {
+            out[i] = words[size - n + i];
+        }
+        std::stable_sort(out, out + n, [](const char *a, const char *b) { return compare(a, b) > 0; });
+    }
+
+    // Call insertLine on each line of the file, without its newline.
+    // Returns false if the file cannot be opened.
+    template <class InsertLine>
+    bool readLines(const char *filename, InsertLine insertLine) const {
+        FILE *file = fopen(filename, "r");
+        if (!file) {
+            return false;
+        }
+        char buffer[MAX_WORD_LEN];
+        while (fgets(buffer, MAX_WORD_LEN, file)) {
+            buffer[strcspn(buffer, "\n")] = 0;
+            insertLine(buffer);
+        }
+        fclose(file);
+        return true;
+    }
+
+    // Write one word per line. Returns false if the file cannot be opened.
+    bool writeLines(const char *filename) const {
+        FILE *file = fopen(filename, "w");
+        if (!file) {
+            return false;
+        }
+        for (int i = 0; i < size; i++) {
+            fprintf(file, "%s\n", words[i]);
+        }
+        fclose(file);
+        return true;
+    }
+
+private:
+    char *copyText(const char *str, size_t len) {
+        ArenaChunk *chunk = chunks;
+        if (!chunk || chunk->capacity - chunk->used < len) {
+            size_t capacity = len > ARENA_CHUNK_SIZE ? len : ARENA_CHUNK_SIZE;
+            chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + capacity);
+            if (!chunk) {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(1);
+            }
+            chunk->used = 0;
+            chunk->capacity = capacity;
+            // An oversized word gets a chunk of its own; keep filling the current one
+            if (capacity > ARENA_CHUNK_SIZE && chunks) {
+                chunk->next = chunks->next;
+                chunks->next = chunk;
+            } else {
+                chunk->next = chunks;
+                chunks = chunk;
+            }
+        }
+        char *block = (char *)(chunk + 1) + chunk->used;
+        memcpy(block, str, len);
+        chunk->used += len;
+        return block;
+    }
+
+    void releaseChunks() {
+        while (chunks) {
+            ArenaChunk *next = chunks->next;
+            free(chunks);
+            chunks = next;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,628 @@
+// Benchmarks for the WordList programs.
+//
+// The benchmark is compiled against one of the programs, which it includes
+// with its main() renamed, so the same suite can be run for each of them
+// (more.c is linked with the rest of its program in wordlist/):
+//
+//   gcc -O2 -pthread -o bench bench.c wordlist/*.c                     (more.c)
+//   gcc -O2 -pthread -DWORDLIST_SOURCE='"new.c"' -o bench-new bench.c
+//   g++ -O2 -x c++ -DWORDLIST_SOURCE='"First.cpp"' -o bench-first bench.c
+//
+//   ./bench [options]      time insert, findfwd, findrev, showrev, load and save
+//                          (more.c also reports its finds through the cache)
+//   ./bench kernels        compare the substring search kernels
+//
+// Results are printed one JSON object per line (or as a table with
+// --format text), so runs of different programs can be diffed or collected.
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef WORDLIST_SOURCE
+#define WORDLIST_SOURCE "more.c"
+#endif
+
+#define main wordlistMain
+#include WORDLIST_SOURCE
+#undef main
+
+// Count heap calls by interposing the allocator (glibc exports the real one
+// under __libc_* names). Elsewhere the allocation columns read -1.
+static long benchAllocs = 0;
+static long benchAllocBytes = 0;
+#ifdef __GLIBC__
+#define BENCH_COUNTS_ALLOCS 1
+#ifdef __cplusplus
+#define BENCH_NOTHROW noexcept
+extern "C" {
+#else
+#define BENCH_NOTHROW
+#endif
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) BENCH_NOTHROW
+{
+    benchAllocs++;
+    benchAllocBytes += (long)size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) BENCH_NOTHROW
+{
+    benchAllocs++;
+    benchAllocBytes += (long)(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) BENCH_NOTHROW
+{
+    benchAllocs++;
+    benchAllocBytes += (long)size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) BENCH_NOTHROW
+{
+    __libc_free(ptr);
+}
+#ifdef __cplusplus
+}
+#endif
+#else
+#define BENCH_COUNTS_ALLOCS 0
+#endif
+
+typedef char *(*SearchFn)(const char *haystack, const char *needle);
+typedef char *(*KernelFn)(const char *haystack, size_t hlen, const char *needle, size_t nlen);
+
+typedef struct
+{
+    int words;
+    int minLen;
+    int maxLen;
+    int geometric;
+    double selectivity;
+    int queries;
+    int showrevWindow;
+    int showrevCalls;
+    int text;
+    unsigned seed;
+} BenchOptions;
+
+typedef struct
+{
+    struct timespec start;
+    long allocs;
+    long allocBytes;
+} BenchTimer;
+
+static FILE *results;
+static const char *marker = "xq";
+static const char *pattern = "XQ";
+
+static unsigned long long benchRandomState = 88172645463325252ull;
+
+static unsigned benchRandom(void)
+{
+    benchRandomState ^= benchRandomState << 13;
+    benchRandomState ^= benchRandomState >> 7;
+    benchRandomState ^= benchRandomState << 17;
+    return (unsigned)(benchRandomState >> 11);
+}
+
+static double benchUniform(void)
+{
+    return (benchRandom() & 0xffffff) / (double)0x1000000;
+}
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// ----------------------------------------------------------------------------
+// Corpus generation
+
+static int wordLength(const BenchOptions *opts)
+{
+    int span = opts->maxLen - opts->minLen;
+    if (span <= 0)
+    {
+        return opts->minLen;
+    }
+    if (opts->geometric)
+    {
+        // Mostly short words with a long tail, like natural text
+        int len = opts->minLen;
+        while (len < opts->maxLen && benchUniform() < 0.7)
+        {
+            len++;
+        }
+        return len;
+    }
+    return opts->minLen + (int)(benchRandom() % (unsigned)(span + 1));
+}
+
+// Every word ends in '-' so more.c's alphanumeric check accepts it, and the
+// selected fraction contain the marker the finds look for. The marker
+// letters never appear anywhere else.
+static char *makeWord(const BenchOptions *opts)
+{
+    static const char letters[] = "abcdefghijklmnoprstuvwyzABCDEFGHIJKLMNOPRSTUVWYZ";
+    int len = wordLength(opts);
+    if (len < 4)
+    {
+        len = 4;
+    }
+    char *word = (char *)malloc(len + 1);
+    for (int i = 0; i < len - 1; i++)
+    {
+        word[i] = letters[benchRandom() % (sizeof(letters) - 1)];
+    }
+    word[len - 1] = '-';
+    word[len] = 0;
+    if (benchUniform() < opts->selectivity)
+    {
+        memcpy(word + benchRandom() % (unsigned)(len - 2), marker, 2);
+    }
+    return word;
+}
+
+static char **makeCorpus(const BenchOptions *opts)
+{
+    char **corpus = (char **)malloc(opts->words * sizeof(char *));
+    for (int i = 0; i < opts->words; i++)
+    {
+        corpus[i] = makeWord(opts);
+    }
+    return corpus;
+}
+
+static void freeCorpus(char **corpus, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        free(corpus[i]);
+    }
+    free(corpus);
+}
+
+// ----------------------------------------------------------------------------
+// Measurement and reporting
+
+static void timerStart(BenchTimer *timer)
+{
+    timer->allocs = benchAllocs;
+    timer->allocBytes = benchAllocBytes;
+    clock_gettime(CLOCK_MONOTONIC, &timer->start);
+}
+
+static void report(const BenchOptions *opts, const char *op, const BenchTimer *timer, long ops, double bytes)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ns = (end.tv_sec - timer->start.tv_sec) * 1e9 + (end.tv_nsec - timer->start.tv_nsec);
+    long allocs = BENCH_COUNTS_ALLOCS ? benchAllocs - timer->allocs : -1;
+    long allocBytes = BENCH_COUNTS_ALLOCS ? benchAllocBytes - timer->allocBytes : -1;
+    double nsPerOp = ops > 0 ? ns / ops : 0;
+    double opsPerSec = ns > 0 ? ops * 1e9 / ns : 0;
+    double mbPerSec = ns > 0 ? bytes * 1e3 / ns : 0;
+    double allocsPerOp = BENCH_COUNTS_ALLOCS && ops > 0 ? (double)allocs / ops : -1;
+    if (opts->text)
+    {
+        fprintf(results, "%-10s %-14s %10ld ops %12.1f ns/op %14.0f ops/s %9.1f MB/s %9.3f allocs/op\n",
+                WORDLIST_SOURCE, op, ops, nsPerOp, opsPerSec, mbPerSec, allocsPerOp);
+    }
+    else
+    {
+        fprintf(results,
+                "{\"impl\":\"%s\",\"op\":\"%s\",\"words\":%d,\"min_len\":%d,\"max_len\":%d,"
+                "\"length_dist\":\"%s\",\"selectivity\":%g,\"ops\":%ld,\"ns_per_op\":%.1f,"
+                "\"ops_per_sec\":%.0f,\"mb_per_sec\":%.1f,\"allocs\":%ld,\"alloc_bytes\":%ld,"
+                "\"allocs_per_op\":%.3f}\n",
+                WORDLIST_SOURCE, op, opts->words, opts->minLen, opts->maxLen,
+                opts->geometric ? "geometric" : "uniform", opts->selectivity, ops, nsPerOp,
+                opsPerSec, mbPerSec, allocs, allocBytes, allocsPerOp);
+    }
+    fflush(results);
+}
+
+static double corpusBytes(char **corpus, int count)
+{
+    double bytes = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bytes += strlen(corpus[i]) + 1;
+    }
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------
+// The operation suite
+
+static void runOps(const BenchOptions *opts)
+{
+    benchRandomState ^= opts->seed * 0x9E3779B97F4A7C15ull;
+    char **corpus = makeCorpus(opts);
+    double bytes = corpusBytes(corpus, opts->words);
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/wordlist-bench-%d.txt", (int)getpid());
+    char filename[64];
+    BenchTimer timer;
+    WordList list;
+
+    // The programs report every operation on stdout; send that to /dev/null
+    // so the numbers measure the work plus formatting, not the terminal.
+    fflush(stdout);
+    if (!freopen("/dev/null", "w", stdout))
+    {
+        fprintf(stderr, "Cannot redirect stdout\n");
+        exit(1);
+    }
+
+    initWordList(&list);
+    timerStart(&timer);
+    for (int i = 0; i < opts->words; i++)
+    {
+        insert(&list, corpus[i]);
+    }
+    report(opts, "insert", &timer, opts->words, bytes);
+
+    // Queries ask for early, middle and missing occurrences of the marker
+    int expected = (int)(opts->words * opts->selectivity);
+    int *nths = (int *)malloc(opts->queries * sizeof(int));
+    for (int q = 0; q < opts->queries; q++)
+    {
+        nths[q] = 1 + (int)(benchRandom() % (unsigned)(expected + 2));
+    }
+#ifdef PATTERN_CACHE_SLOTS
+    // more.c answers repeated patterns from its cache; scan without it so
+    // findfwd and findrev compare with the other programs
+    setCache(&list, "off");
+#endif
+    timerStart(&timer);
+    for (int q = 0; q < opts->queries; q++)
+    {
+        findfwd(&list, pattern, nths[q]);
+    }
+    report(opts, "findfwd", &timer, opts->queries, bytes * opts->queries);
+    timerStart(&timer);
+    for (int q = 0; q < opts->queries; q++)
+    {
+        findrev(&list, pattern, nths[q]);
+    }
+    report(opts, "findrev", &timer, opts->queries, bytes * opts->queries);
+#ifdef PATTERN_CACHE_SLOTS
+    // The same queries again through a cache that starts out empty
+    setCache(&list, "on");
+    timerStart(&timer);
+    for (int q = 0; q < opts->queries; q++)
+    {
+        findfwd(&list, pattern, nths[q]);
+    }
+    report(opts, "findfwd_cached", &timer, opts->queries, bytes * opts->queries);
+    timerStart(&timer);
+    for (int q = 0; q < opts->queries; q++)
+    {
+        findrev(&list, pattern, nths[q]);
+    }
+    report(opts, "findrev_cached", &timer, opts->queries, bytes * opts->queries);
+#endif
+    free(nths);
+
+    // Alternate showrev with single inserts, the pattern a live session produces
+    timerStart(&timer);
+    for (int c = 0; c < opts->showrevCalls; c++)
+    {
+        showrev(&list, opts->showrevWindow);
+        insert(&list, corpus[c % opts->words]);
+    }
+    report(opts, "showrev", &timer, opts->showrevCalls, 0);
+
+    snprintf(filename, sizeof(filename), "%s", path);
+    timerStart(&timer);
+    save(&list, filename);
+    report(opts, "save", &timer, list.size, bytes);
+    freeWordList(&list);
+
+    initWordList(&list);
+    snprintf(filename, sizeof(filename), "%s", path);
+    timerStart(&timer);
+    load(&list, filename);
+    report(opts, "load", &timer, list.size, bytes);
+    freeWordList(&list);
+
+    unlink(path);
+    freeCorpus(corpus, opts->words);
+}
+
+// ----------------------------------------------------------------------------
+// Search kernel comparison
+
+// The byte-at-a-time search new.c and more.c used before the kernels
+char *referenceStrcasestr(const char *haystack, const char *needle)
+{
+    if (!*needle) return (char *)haystack;
+    size_t nlen = strlen(needle);
+    for (size_t i = 0; haystack[i]; i++)
+    {
+        size_t j = 0;
+        while (j < nlen && haystack[i + j] &&
+               tolower((unsigned char)haystack[i + j]) == tolower((unsigned char)needle[j]))
+        {
+            j++;
+        }
+        if (j == nlen) return (char *)(haystack + i);
+    }
+    return NULL;
+}
+
+// The copy-and-lowercase search First.cpp used before the kernels
+char *copyingStrcasestr(const char *haystack, const char *needle)
+{
+    char *h = strdup(haystack);
+    char *n = strdup(needle);
+    for (char *p = h; *p; p++) *p = tolower((unsigned char)*p);
+    for (char *p = n; *p; p++) *p = tolower((unsigned char)*p);
+    char *result = strstr(h, n);
+    if (result)
+    {
+        result = (char *)(haystack + (result - h));
+    }
+    free(h);
+    free(n);
+    return result;
+}
+
+char *dispatchStrcasestr(const char *haystack, const char *needle)
+{
+    return (char *)strcasestr(haystack, needle);
+}
+
+static KernelFn benchKernel;
+
+char *viaKernel(const char *haystack, const char *needle)
+{
+    size_t nlen = strlen(needle);
+    size_t hlen = strlen(haystack);
+    if (hlen < nlen) return NULL;
+    return benchKernel(haystack, hlen, needle, nlen);
+}
+
+static void randomText(char *out, size_t len)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ-' ";
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = alphabet[benchRandom() % (sizeof(alphabet) - 1)];
+    }
+    out[len] = 0;
+}
+
+static double timeSearch(SearchFn fn, char **words, int count, char **needles, int needleCount, int rounds, long *hits)
+{
+    double start = nowNs();
+    long found = 0;
+    for (int r = 0; r < rounds; r++)
+    {
+        const char *needle = needles[r % needleCount];
+        for (int i = 0; i < count; i++)
+        {
+            found += fn(words[i], needle) != NULL;
+        }
+    }
+    *hits = found;
+    return (nowNs() - start) / ((double)rounds * count);
+}
+
+static void runKernelCase(const char *label, size_t wordLen, int count, int rounds)
+{
+    char **words = (char **)malloc(count * sizeof(char *));
+    char *needles[16];
+    for (int i = 0; i < count; i++)
+    {
+        words[i] = (char *)malloc(wordLen + 1);
+        randomText(words[i], wordLen);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        size_t len = 2 + i % 4;
+        needles[i] = (char *)malloc(len + 1);
+        // Half of the needles are lifted from the corpus so some searches hit
+        if (i % 2 == 0 && wordLen >= len)
+        {
+            const char *src = words[benchRandom() % count];
+            size_t at = benchRandom() % (wordLen - len + 1);
+            memcpy(needles[i], src + at, len);
+            needles[i][len] = 0;
+        }
+        else
+        {
+            randomText(needles[i], len);
+        }
+    }
+
+    // Every kernel must agree with the reference on every position
+    for (int n = 0; n < 16; n++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            char *expected = referenceStrcasestr(words[i], needles[n]);
+            if (dispatchStrcasestr(words[i], needles[n]) != expected)
+            {
+                fprintf(stderr, "Mismatch on '%s' / '%s'\n", words[i], needles[n]);
+                exit(1);
+            }
+        }
+    }
+
+    struct
+    {
+        const char *name;
+        SearchFn search;
+        KernelFn kernel;
+    } variants[] = {
+        {"bytewise", referenceStrcasestr, NULL},
+        {"copy+strstr", copyingStrcasestr, NULL},
+        {"scalar", viaKernel, strcasestrScalar},
+#ifdef WORDLIST_X86_SIMD
+        {"sse2", viaKernel, strcasestrSse2},
+        {"avx2", viaKernel, strcasestrAvx2},
+#endif
+        {"dispatch", dispatchStrcasestr, NULL},
+    };
+    int variantCount = (int)(sizeof(variants) / sizeof(variants[0]));
+    double baseline = 0;
+    printf("%s (%zu bytes, %d words)\n", label, wordLen, count);
+    for (int v = 0; v < variantCount; v++)
+    {
+#ifdef WORDLIST_X86_SIMD
+        if (variants[v].kernel == strcasestrAvx2 && !__builtin_cpu_supports("avx2"))
+        {
+            continue;
+        }
+#endif
+        long hits;
+        benchKernel = variants[v].kernel;
+        double ns = timeSearch(variants[v].search, words, count, needles, 16, rounds, &hits);
+        if (v == 0)
+        {
+            baseline = ns;
+        }
+        printf("  %-12s %8.2f ns/call  %6.2fx  (%ld hits)\n", variants[v].name, ns, baseline / ns, hits);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        free(words[i]);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        free(needles[i]);
+    }
+    free(words);
+}
+
+static void runKernels(void)
+{
+#ifdef WORDLIST_X86_SIMD
+    __builtin_cpu_init();
+#endif
+    runKernelCase("short words", 8, 100000, 32);
+    runKernelCase("medium words", 32, 50000, 32);
+    runKernelCase("long words", 256, 10000, 32);
+}
+
+// ----------------------------------------------------------------------------
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [kernels] [options]\n"
+            "  --words N          corpus size (default 200000)\n"
+            "  --len MIN:MAX      word length range (default 4:12)\n"
+            "  --dist uniform|geometric\n"
+            "                     word length distribution (default uniform)\n"
+            "  --selectivity P    fraction of words the finds match (default 0.01)\n"
+            "  --queries N        findfwd/findrev calls (default 50)\n"
+            "  --window N         showrev window (default 1000)\n"
+            "  --showrev N        showrev calls (default 200)\n"
+            "  --seed N           corpus seed (default 1)\n"
+            "  --format json|text output format (default json)\n",
+            program);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts = {200000, 4, 12, 0, 0.01, 50, 1000, 200, 0, 1};
+    int kernels = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "kernels") == 0)
+        {
+            kernels = 1;
+            continue;
+        }
+        if (!value)
+        {
+            usage(argv[0]);
+        }
+        i++;
+        if (strcmp(arg, "--words") == 0)
+        {
+            opts.words = atoi(value);
+        }
+        else if (strcmp(arg, "--len") == 0)
+        {
+            if (sscanf(value, "%d:%d", &opts.minLen, &opts.maxLen) != 2)
+            {
+                usage(argv[0]);
+            }
+        }
+        else if (strcmp(arg, "--dist") == 0)
+        {
+            opts.geometric = strcmp(value, "geometric") == 0;
+        }
+        else if (strcmp(arg, "--selectivity") == 0)
+        {
+            opts.selectivity = atof(value);
+        }
+        else if (strcmp(arg, "--queries") == 0)
+        {
+            opts.queries = atoi(value);
+        }
+        else if (strcmp(arg, "--window") == 0)
+        {
+            opts.showrevWindow = atoi(value);
+        }
+        else if (strcmp(arg, "--showrev") == 0)
+        {
+            opts.showrevCalls = atoi(value);
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            opts.seed = (unsigned)atoi(value);
+        }
+        else if (strcmp(arg, "--format") == 0)
+        {
+            opts.text = strcmp(value, "text") == 0;
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+    // Lines longer than MAX_WORD_LEN would be split by load
+    if (opts.words < 1 || opts.minLen < 1 || opts.maxLen < opts.minLen || opts.maxLen >= MAX_WORD_LEN - 1 ||
+        opts.queries < 1 ||
+        opts.showrevWindow < 1 || opts.showrevCalls < 1 || opts.selectivity < 0 || opts.selectivity > 1)
+    {
+        usage(argv[0]);
+    }
+
+    if (kernels)
+    {
+        runKernels();
+        return 0;
+    }
+    results = fdopen(dup(STDOUT_FILENO), "w");
+    if (!results)
+    {
+        fprintf(stderr, "Cannot open results stream\n");
+        return 1;
+    }
+    runOps(&opts);
+    fclose(results);
+    return 0;
+}
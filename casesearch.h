@@ -0,0 +1,150 @@
+// Case-insensitive substring search kernels shared by more (through
+// wordlist/wordlist.h), new.c and WordList.hpp. Everything here is static
+// so the header can be included by any C or C++ translation unit.
+#ifndef CASESEARCH_H
+#define CASESEARCH_H
+
+#include <stddef.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#include <immintrin.h>
+#define WORDLIST_X86_SIMD
+#endif
+
+typedef char *(*SearchKernel)(const char *haystack, size_t hlen, const char *needle, size_t nlen);
+
+// Fold an ASCII letter to lower case (same result as tolower in the C locale)
+static inline unsigned char foldByte(unsigned char c)
+{
+    return (unsigned)(c - 'A') < 26u ? (unsigned char)(c + 32) : c;
+}
+
+static inline int equalFolded(const char *a, const char *b, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (foldByte((unsigned char)a[i]) != foldByte((unsigned char)b[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// The search kernels all take explicit lengths, require 0 < nlen <= hlen and
+// return the leftmost match. Candidates are filtered on the first and last
+// needle byte before the middle is compared.
+static inline char *strcasestrScalar(const char *haystack, size_t hlen, const char *needle, size_t nlen)
+{
+    unsigned char first = foldByte((unsigned char)needle[0]);
+    unsigned char last = foldByte((unsigned char)needle[nlen - 1]);
+    for (size_t i = 0; i + nlen <= hlen; i++)
+    {
+        if (foldByte((unsigned char)haystack[i]) == first &&
+            foldByte((unsigned char)haystack[i + nlen - 1]) == last &&
+            equalFolded(haystack + i + 1, needle + 1, nlen > 2 ? nlen - 2 : 0))
+        {
+            return (char *)(haystack + i);
+        }
+    }
+    return NULL;
+}
+
+#ifdef WORDLIST_X86_SIMD
+static inline __m128i foldBlockSse2(__m128i block)
+{
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+static inline char *strcasestrSse2(const char *haystack, size_t hlen, const char *needle, size_t nlen)
+{
+    const __m128i first = _mm_set1_epi8((char)foldByte((unsigned char)needle[0]));
+    const __m128i last = _mm_set1_epi8((char)foldByte((unsigned char)needle[nlen - 1]));
+    size_t i = 0;
+    for (; i + nlen - 1 + 16 <= hlen; i += 16)
+    {
+        __m128i head = foldBlockSse2(_mm_loadu_si128((const __m128i *)(haystack + i)));
+        __m128i tail = foldBlockSse2(_mm_loadu_si128((const __m128i *)(haystack + i + nlen - 1)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last)));
+        while (mask)
+        {
+            size_t at = i + (size_t)__builtin_ctz(mask);
+            if (equalFolded(haystack + at + 1, needle + 1, nlen > 2 ? nlen - 2 : 0))
+            {
+                return (char *)(haystack + at);
+            }
+            mask &= mask - 1;
+        }
+    }
+    return strcasestrScalar(haystack + i, hlen - i, needle, nlen);
+}
+
+__attribute__((target("avx2"))) static inline __m256i foldBlockAvx2(__m256i block)
+{
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+    return _mm256_or_si256(block, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static inline char *strcasestrAvx2(const char *haystack, size_t hlen, const char *needle, size_t nlen)
+{
+    if (hlen < nlen - 1 + 32)
+    {
+        return strcasestrSse2(haystack, hlen, needle, nlen);
+    }
+    const __m256i first = _mm256_set1_epi8((char)foldByte((unsigned char)needle[0]));
+    const __m256i last = _mm256_set1_epi8((char)foldByte((unsigned char)needle[nlen - 1]));
+    size_t i = 0;
+    for (; i + nlen - 1 + 32 <= hlen; i += 32)
+    {
+        __m256i head = foldBlockAvx2(_mm256_loadu_si256((const __m256i *)(haystack + i)));
+        __m256i tail = foldBlockAvx2(_mm256_loadu_si256((const __m256i *)(haystack + i + nlen - 1)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first), _mm256_cmpeq_epi8(tail, last)));
+        while (mask)
+        {
+            size_t at = i + (size_t)__builtin_ctz(mask);
+            if (equalFolded(haystack + at + 1, needle + 1, nlen > 2 ? nlen - 2 : 0))
+            {
+                return (char *)(haystack + at);
+            }
+            mask &= mask - 1;
+        }
+    }
+    // Leave AVX state clean before handing the tail to the SSE2 kernel
+    _mm256_zeroupper();
+    return strcasestrSse2(haystack + i, hlen - i, needle, nlen);
+}
+#endif
+
+// The widest kernel the CPU supports
+static inline SearchKernel selectSearchKernel(void)
+{
+#ifdef WORDLIST_X86_SIMD
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? strcasestrAvx2 : strcasestrSse2;
+#else
+    return strcasestrScalar;
+#endif
+}
+
+// Search through the kernel picked the first time a search runs. Server
+// readers may race to pick it, so the pointer is accessed atomically; they
+// all pick the same one.
+static inline char *searchFolded(const char *haystack, size_t hlen, const char *needle, size_t nlen)
+{
+    static SearchKernel kernel;
+    SearchKernel chosen = __atomic_load_n(&kernel, __ATOMIC_RELAXED);
+    if (!chosen)
+    {
+        chosen = selectSearchKernel();
+        __atomic_store_n(&kernel, chosen, __ATOMIC_RELAXED);
+    }
+    return chosen(haystack, hlen, needle, nlen);
+}
+
+#endif
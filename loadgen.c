@@ -0,0 +1,362 @@
+// Load generator for more.c's server mode.
+//
+// Start a server, then point any number of simulated clients at it:
+//
+//   gcc -O2 -pthread -o more more.c wordlist/*.c
+//   gcc -O2 -pthread -o loadgen loadgen.c
+//
+//   ./more -q -l /tmp/wordlist.sock &
+//   ./loadgen -s /tmp/wordlist.sock [options]
+//
+// Each client sends a mix of inserts and findfwd/findrev/showrev queries on
+// its own connection and waits for every reply. Throughput and per-operation
+// latency percentiles are printed one JSON object per line (or as a table
+// with --format text), like bench.c's results.
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+enum
+{
+    OP_INSERT,
+    OP_FINDFWD,
+    OP_FINDREV,
+    OP_SHOWREV,
+    OP_KINDS
+};
+
+static const char *opNames[OP_KINDS] = {"insert", "findfwd", "findrev", "showrev"};
+
+typedef struct
+{
+    const char *socket;
+    int clients;
+    int requests;
+    int writes;
+    int window;
+    int text;
+    unsigned seed;
+} LoadOptions;
+
+// One client's latencies, in nanoseconds, kept per operation
+typedef struct
+{
+    const LoadOptions *opts;
+    pthread_t thread;
+    unsigned long long random;
+    double *latencies[OP_KINDS];
+    int counts[OP_KINDS];
+    int failed;
+} LoadClient;
+
+static unsigned loadRandom(LoadClient *client)
+{
+    client->random ^= client->random << 13;
+    client->random ^= client->random >> 7;
+    client->random ^= client->random << 17;
+    return (unsigned)(client->random >> 11);
+}
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int connectServer(const char *path)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Send one command and read its reply, which the server ends with a NUL byte
+static int request(int fd, const char *line, size_t length)
+{
+    size_t sent = 0;
+    while (sent < length)
+    {
+        ssize_t n = send(fd, line + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return 0;
+        }
+        sent += (size_t)n;
+    }
+    char buffer[4096];
+    for (;;)
+    {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+        {
+            return 0;
+        }
+        // Requests are sent one at a time, so the NUL can only be the last byte
+        if (buffer[n - 1] == 0)
+        {
+            return 1;
+        }
+    }
+}
+
+// Words end in '-' so the server's alphanumeric check accepts them; the
+// queries look for two-letter patterns that a fair share of them contain
+static void makeLine(LoadClient *client, int op, char *line, size_t size)
+{
+    static const char letters[] = "abcdefgh";
+    char word[16];
+    int len = 3 + (int)(loadRandom(client) % 8);
+    for (int i = 0; i < len; i++)
+    {
+        word[i] = letters[loadRandom(client) % (sizeof(letters) - 1)];
+    }
+    switch (op)
+    {
+    case OP_INSERT:
+        word[len] = '-';
+        word[len + 1] = 0;
+        snprintf(line, size, "insert %s\n", word);
+        break;
+    case OP_FINDFWD:
+    case OP_FINDREV:
+        word[2] = 0;
+        snprintf(line, size, "%s %s %u\n", opNames[op], word, 1 + loadRandom(client) % 10);
+        break;
+    default:
+        snprintf(line, size, "showrev %d\n", client->opts->window);
+        break;
+    }
+}
+
+static void *runClient(void *arg)
+{
+    LoadClient *client = (LoadClient *)arg;
+    const LoadOptions *opts = client->opts;
+    int fd = connectServer(opts->socket);
+    if (fd < 0)
+    {
+        client->failed = 1;
+        return NULL;
+    }
+    char line[64];
+    for (int i = 0; i < opts->requests; i++)
+    {
+        int op = OP_INSERT;
+        if ((int)(loadRandom(client) % 100) >= opts->writes)
+        {
+            op = OP_FINDFWD + (int)(loadRandom(client) % 3);
+        }
+        makeLine(client, op, line, sizeof(line));
+        double started = nowNs();
+        if (!request(fd, line, strlen(line)))
+        {
+            client->failed = 1;
+            break;
+        }
+        client->latencies[op][client->counts[op]++] = nowNs() - started;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    int i = (int)(p * (count - 1) + 0.5);
+    return sorted[i];
+}
+
+static void report(const LoadOptions *opts, const char *op, double *latencies, int count, double ns)
+{
+    qsort(latencies, count, sizeof(double), compareDoubles);
+    double opsPerSec = ns > 0 ? count * 1e9 / ns : 0;
+    double p50 = percentile(latencies, count, 0.50) / 1e3;
+    double p99 = percentile(latencies, count, 0.99) / 1e3;
+    if (opts->text)
+    {
+        printf("%-8s %10d ops %12.0f ops/s %10.1f us p50 %10.1f us p99\n", op, count, opsPerSec, p50, p99);
+    }
+    else
+    {
+        printf("{\"op\":\"%s\",\"clients\":%d,\"writes\":%d,\"ops\":%d,\"ops_per_sec\":%.0f,"
+               "\"p50_us\":%.1f,\"p99_us\":%.1f}\n",
+               op, opts->clients, opts->writes, count, opsPerSec, p50, p99);
+    }
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s -s socket [options]\n"
+            "  -s, --socket PATH  the server's socket\n"
+            "  --clients N        concurrent connections (default 8)\n"
+            "  --requests N       requests per client (default 10000)\n"
+            "  --writes PCT       percentage of requests that insert (default 10)\n"
+            "  --window N         showrev window (default 100)\n"
+            "  --seed N           request seed (default 1)\n"
+            "  --format json|text output format (default json)\n",
+            program);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions opts = {NULL, 8, 10000, 10, 100, 0, 1};
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value)
+        {
+            usage(argv[0]);
+        }
+        i++;
+        if (strcmp(arg, "-s") == 0 || strcmp(arg, "--socket") == 0)
+        {
+            opts.socket = value;
+        }
+        else if (strcmp(arg, "--clients") == 0)
+        {
+            opts.clients = atoi(value);
+        }
+        else if (strcmp(arg, "--requests") == 0)
+        {
+            opts.requests = atoi(value);
+        }
+        else if (strcmp(arg, "--writes") == 0)
+        {
+            opts.writes = atoi(value);
+        }
+        else if (strcmp(arg, "--window") == 0)
+        {
+            opts.window = atoi(value);
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            opts.seed = (unsigned)atoi(value);
+        }
+        else if (strcmp(arg, "--format") == 0)
+        {
+            opts.text = strcmp(value, "text") == 0;
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+    if (!opts.socket || opts.clients < 1 || opts.requests < 1 || opts.writes < 0 || opts.writes > 100 ||
+        opts.window < 1)
+    {
+        usage(argv[0]);
+    }
+
+    LoadClient *clients = (LoadClient *)calloc(opts.clients, sizeof(LoadClient));
+    if (!clients)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+    for (int c = 0; c < opts.clients; c++)
+    {
+        clients[c].opts = &opts;
+        clients[c].random = 88172645463325252ull ^ (opts.seed * 0x9E3779B97F4A7C15ull + c + 1);
+        for (int op = 0; op < OP_KINDS; op++)
+        {
+            clients[c].latencies[op] = (double *)malloc(opts.requests * sizeof(double));
+            if (!clients[c].latencies[op])
+            {
+                fprintf(stderr, "Memory allocation failed\n");
+                return 1;
+            }
+        }
+    }
+
+    double started = nowNs();
+    for (int c = 0; c < opts.clients; c++)
+    {
+        if (pthread_create(&clients[c].thread, NULL, runClient, &clients[c]) != 0)
+        {
+            fprintf(stderr, "Cannot start client %d\n", c);
+            return 1;
+        }
+    }
+    int failed = 0;
+    for (int c = 0; c < opts.clients; c++)
+    {
+        pthread_join(clients[c].thread, NULL);
+        failed += clients[c].failed;
+    }
+    double ns = nowNs() - started;
+    if (failed)
+    {
+        fprintf(stderr, "%d of %d clients lost their connection to '%s'\n", failed, opts.clients, opts.socket);
+    }
+
+    // Merge the clients' latencies per operation, then over all of them
+    int total = opts.clients * opts.requests;
+    double *all = (double *)malloc(total * sizeof(double));
+    double *merged = (double *)malloc(total * sizeof(double));
+    if (!all || !merged)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+    int allCount = 0;
+    for (int op = 0; op < OP_KINDS; op++)
+    {
+        int count = 0;
+        for (int c = 0; c < opts.clients; c++)
+        {
+            memcpy(merged + count, clients[c].latencies[op], clients[c].counts[op] * sizeof(double));
+            count += clients[c].counts[op];
+        }
+        memcpy(all + allCount, merged, count * sizeof(double));
+        allCount += count;
+        report(&opts, opNames[op], merged, count, ns);
+    }
+    report(&opts, "all", all, allCount, ns);
+
+    free(all);
+    free(merged);
+    for (int c = 0; c < opts.clients; c++)
+    {
+        for (int op = 0; op < OP_KINDS; op++)
+        {
+            free(clients[c].latencies[op]);
+        }
+    }
+    free(clients);
+    return failed ? 1 : 0;
+}
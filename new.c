@@ -3,13 +3,24 @@
 #include <string.h>
 #include <ctype.h>
 
+#include "casesearch.h"
+
 #define MAX_WORD_LEN 256
 #define INITIAL_CAPACITY 10
+#define ARENA_CHUNK_SIZE (1 << 20)
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *next;
+    size_t used;
+    size_t capacity;
+} ArenaChunk;
 
 typedef struct {
     char **words;
     int size;
     int capacity;
+    ArenaChunk *chunks;
 } WordList;
 
 char *trim(char *str)
@@ -27,6 +38,7 @@ void initWordList(WordList *list)
 {
     list->capacity = INITIAL_CAPACITY;
     list->size = 0;
+    list->chunks = NULL;
     list->words = (char **)malloc(list->capacity * sizeof(char *));
     if (!list->words)
     {
@@ -50,15 +62,52 @@ void resizeWordList(WordList *list)
 
 void freeWordList(WordList *list)
 {
-    for (int i = 0; i < list->size; i++)
-  {
-        free(list->words[i]);
+    while (list->chunks)
+    {
+        ArenaChunk *next = list->chunks->next;
+        free(list->chunks);
+        list->chunks = next;
     }
     free(list->words);
     list->size = 0;
     list->capacity = 0;
 }
 
+// Copy a word into the list's arena. Words are packed back to back into
+// large chunks, so the whole list is released with a handful of frees.
+char *arenaStrdup(WordList *list, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    ArenaChunk *chunk = list->chunks;
+    if (!chunk || chunk->capacity - chunk->used < len)
+    {
+        size_t capacity = len > ARENA_CHUNK_SIZE ? len : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + capacity);
+        if (!chunk)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        // An oversized word gets a chunk of its own; keep filling the current one
+        if (capacity > ARENA_CHUNK_SIZE && list->chunks)
+        {
+            chunk->next = list->chunks->next;
+            list->chunks->next = chunk;
+        }
+        else
+        {
+            chunk->next = list->chunks;
+            list->chunks = chunk;
+        }
+    }
+    char *copy = (char *)(chunk + 1) + chunk->used;
+    memcpy(copy, str, len);
+    chunk->used += len;
+    return copy;
+}
+
 int strcasecmp(const char *s1, const char *s2)
 {
     while (*s1 && *s2)
@@ -77,17 +126,9 @@ char *strcasestr(const char *haystack, const char *needle)
 {
     if (!*needle) return (char *)haystack;
     size_t nlen = strlen(needle);
-    for (size_t i = 0; haystack[i]; i++)
-    {
-        size_t j = 0;
-        while (j < nlen && haystack[i + j] &&
-               tolower((unsigned char)haystack[i + j]) == tolower((unsigned char)needle[j]))
-        {
-            j++;
-        }
-        if (j == nlen) return (char *)(haystack + i);
-    }
-    return NULL;
+    size_t hlen = strlen(haystack);
+    if (hlen < nlen) return NULL;
+    return searchFolded(haystack, hlen, needle, nlen);
 }
 
 void insert(WordList *list, const char *word)
@@ -99,12 +140,7 @@ void insert(WordList *list, const char *word)
         return;
     }
     resizeWordList(list);
-    list->words[list->size] = strdup(trimmed);
-    if (!list->words[list->size])
-    {
-        fprintf(stderr, "Memory allocation failed\n");
-        exit(1);
-    }
+    list->words[list->size] = arenaStrdup(list, trimmed);
     list->size++;
     printf("Inserted: %s\n", trimmed);
 }
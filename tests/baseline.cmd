@@ -0,0 +1,53 @@
+insert apple-pie
+insert Banana_split
+insert cherry tart
+insert apple
+insert 12345
+insert
+insert    Grape-Fruit   
+insert APPLE-sauce
+insert pine-apple
+insert a-b-c
+insert Zebra!
+insert zebra?
+insert mango.
+insert Apple-Pies
+findfwd apple 1
+findfwd APPLE 2
+findfwd apple 3
+findfwd apple 4
+findfwd apple 5
+findfwd apple 0
+findfwd apple -2
+findfwd -b- 1
+findfwd kiwi 1
+findrev apple 1
+findrev apple 2
+findrev pie 2
+findrev pie 3
+findrev zebra 1
+findrev e 7
+findrev e 20
+findfwd e 7
+showrev 3
+showrev 5
+showrev 50
+showrev 0
+showrev -1
+findfwd apple
+findrev
+showrev
+nonsense
+nonsense with args
+findsomething apple 1
+insert tail-word
+findrev tail 1
+showrev 2
+findfwd apple 2 extra
+findrev pie 1x
+findfwd apple x
+showrev 2 more words
+showrev 3x
+showrev x
+exit
+insert after-exit
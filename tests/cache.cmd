@@ -0,0 +1,24 @@
+insert red-1
+insert blue-2
+insert Red-3
+findfwd red 1
+findfwd red 2
+findfwd RED 2
+findrev red 1
+insert tired-4
+findrev red 1
+findfwd red 3
+count red
+findall red 2 1
+insert bored-5
+count red
+findrev red 5
+findrev red 6
+cache off
+findfwd red 4
+insert redo-6
+cache on
+findrev red 1
+findfwd red 6
+count red
+cache sometimes
@@ -0,0 +1,66 @@
+compress on
+insert Prefix-Other-00
+insert prefix-shared-01
+insert prefix-shared-02
+insert Prefix-Other-03
+insert prefix-shared-04
+insert prefix-shared-05
+insert Prefix-Other-06
+insert prefix-shared-07
+insert prefix-shared-08
+insert Prefix-Other-09
+insert prefix-shared-10
+insert prefix-shared-11
+insert Prefix-Other-12
+insert prefix-shared-13
+insert prefix-shared-14
+insert Prefix-Other-15
+insert prefix-shared-16
+insert prefix-shared-17
+insert Prefix-Other-18
+insert prefix-shared-19
+insert prefix-shared-20
+insert Prefix-Other-21
+insert prefix-shared-22
+insert prefix-shared-23
+insert Prefix-Other-24
+insert prefix-shared-25
+insert prefix-shared-26
+insert Prefix-Other-27
+insert prefix-shared-28
+insert prefix-shared-29
+insert Prefix-Other-30
+insert prefix-shared-31
+insert prefix-shared-32
+insert Prefix-Other-33
+insert prefix-shared-34
+insert prefix-shared-35
+insert Prefix-Other-36
+insert prefix-shared-37
+insert prefix-shared-38
+insert Prefix-Other-39
+insert long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-end
+insert prefix-shared-07
+count prefix
+findfwd shared-3 1
+findfwd SHARED-3 2
+findrev other 1
+findrev other 14
+findrev other 15
+findfwd end 1
+findall -3 3 1
+findmulti 1 -31 -32 -33
+showrev 4
+save packed.txt
+savebin packed.wl
+compress off
+compress later
+--restart--
+compress on
+loadbin packed.wl
+count shared-0
+findrev prefix 1
+findfwd long-end 1
+--restart--
+insert plain-1
+compress on
@@ -0,0 +1,57 @@
+insert alpha-one
+insert Beta-two
+insert gamma-three
+insert alpha-four
+insert ALPHA-five
+insert delta-six
+insert straße-x
+insert STRASSE-y
+insert Ærø-z
+insert ærø-w
+findall alpha
+findall alpha 2
+findall alpha 2 1
+findall alpha 5 9
+findall zzz
+count alpha
+count A
+count zzz
+findmulti 1 alpha beta zzz
+findmulti 2 alpha a-f
+findmultirev 1 alpha beta zzz
+findmultirev 3 a
+findfwd straße 1
+findfwd STRASSE 2
+findrev ærø 2
+findfwd ÆRØ-W 1
+findall ss
+findall 1 2 3 4
+count
+findmulti 0 alpha
+findmulti x alpha
+findall alpha -1
+save words.txt
+savebin words.bin
+load words.txt
+count alpha
+loadbin words.bin
+count alpha
+findrev alpha 1
+findrev alpha 9
+showrev 4
+load missing.txt
+loadbin missing.bin
+--restart--
+insert kappa-one
+insert Lambda-two
+showrev 2147483647
+insert iota-three
+showrev 5
+showrev 2
+--restart--
+insert long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-long-
+save long.txt
+--restart--
+load long.txt
+findfwd long- 1
+findfwd long- 2
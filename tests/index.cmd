@@ -0,0 +1,23 @@
+insert apple-pie
+insert Pineapple_tart
+insert grape-juice
+index on
+findfwd APP 1
+findfwd app 2
+findfwd app 3
+findrev pie 1
+findrev le 1
+findfwd e_t 1
+findfwd zzz 1
+insert apple_sauce
+insert Ünïcode-apple
+count apple
+findall ple
+findrev APPLE 1
+findfwd ÜNÏ 1
+findfwd nïc 1
+index on
+index off
+count apple
+findfwd e-j 1
+index maybe
@@ -0,0 +1,30 @@
+intern on
+insert dup-1
+insert other-2
+insert dup-1
+insert DUP-1
+insert dup-1
+count dup
+findfwd dup 3
+findrev dup 1
+findrev dup 4
+findall dup 2 2
+showrev 5
+findmulti 2 dup 1
+intern off
+compress on
+save interned.txt
+savebin interned.wl
+--restart--
+intern on
+load interned.txt
+loadbin interned.wl
+count dup-1
+findrev other 2
+--restart--
+insert plain-1
+intern on
+intern perhaps
+--restart--
+compress on
+intern on
@@ -0,0 +1,52 @@
+journal j.wl always
+insert first-1
+insert second-2
+findall -
+--restart--
+journal j.wl always
+insert third-3
+compact
+insert fourth-4
+findall -
+--restart--
+journal j.wl
+findall -
+count -
+journal off
+insert fifth-5
+count -
+--restart--
+journal j.wl always extra
+journal j.wl always
+count -
+journal off
+--restart--
+insert alpha-1
+insert beta-2
+savebin bad.wl
+save bad.wl.log
+--restart--
+journal bad.wl
+count -
+findall -
+journal good.wl
+insert gamma-3
+findall amm
+count -
+--restart--
+journal off
+compact
+journal n.wl sometimes
+insert zeta-9
+journal n.wl
+--restart--
+journal c.wl none
+insert a-1
+insert b-2
+compact
+compact
+insert c-3
+journal off
+--restart--
+journal c.wl periodic
+findall -
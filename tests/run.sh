@@ -0,0 +1,67 @@
+#!/bin/sh
+# Regression tests for more.c.
+#
+#   tests/run.sh [path/to/more]      (default: ./more)
+#
+# Each NAME.cmd is a command script and NAME.out the output it must give.
+# baseline.out is what more printed for baseline.cmd as of the quiet mode
+# change, not the original program's output; it pins the behaviour every
+# later feature must keep. A line '--restart--' ends one run of the program
+# and starts the next in the same directory, for scripts that pick up what
+# an earlier run left on disk.
+#
+# Every script runs once per mode below, with the mode's commands run first
+# and their confirmation lines dropped, since every mode must give the same
+# results. Streaming mode refuses journals, so scripts that open one skip
+# it. Scripts that switch one of the modes themselves run in the default
+# mode only. Load timings are masked.
+
+more=$(cd "$(dirname "${1:-./more}")" && pwd)/$(basename "${1:-./more}")
+tests=$(cd "$(dirname "$0")" && pwd)
+if [ ! -x "$more" ]; then
+    echo "Cannot run '$more'; build it first (see README.md)" >&2
+    exit 2
+fi
+
+modes="default
+cache off
+index on
+threads 4
+intern on
+compress on
+window 1000
+index on;intern on
+cache off;compress on"
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+for script in "$tests"/*.cmd; do
+    name=$(basename "$script" .cmd)
+    printf '%s\n' "$modes" | while read -r mode; do
+        case "$mode" in
+            *window*) grep -q '^journal ' "$script" && continue ;;
+        esac
+        if [ "$mode" != default ] && grep -qE '^(cache|index|threads|intern|compress|window) ' "$script"; then
+            continue
+        fi
+        prelude=$(printf '%s\n' "$mode" | tr ';' '\n' | grep -v '^default$')
+        skip=$(printf '%s' "$prelude" | grep -c .)
+        rm -rf "$work/run" && mkdir "$work/run"
+        awk -v dir="$work" '/^--restart--$/ { n++; next } { print > (dir "/part" n + 0) }' "$script"
+        for part in "$work"/part*; do
+            { [ -n "$prelude" ] && printf '%s\n' "$prelude"; cat "$part"; } |
+                (cd "$work/run" && "$more" -f -) 2>&1 | tail -n +$((skip + 1))
+        done | sed -E 's/ in [0-9]+\.[0-9] ms/ in N ms/' > "$work/actual"
+        rm -f "$work"/part*
+        if diff -u "$tests/$name.out" "$work/actual" > "$work/diff"; then
+            echo "PASS $name ($mode)"
+        else
+            echo "FAIL $name ($mode)"
+            cat "$work/diff"
+            echo failed > "$work/failed"
+        fi
+    done
+done
+if [ -e "$work/failed" ]; then
+    exit 1
+fi
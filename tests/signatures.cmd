@@ -0,0 +1,181 @@
+insert needle-000
+insert hay-001
+insert hay-002
+insert hay-003
+insert hay-004
+insert hay-005
+insert hay-006
+insert hay-007
+insert hay-008
+insert hay-009
+insert hay-010
+insert hay-011
+insert hay-012
+insert hay-013
+insert hay-014
+insert hay-015
+insert hay-016
+insert hay-017
+insert hay-018
+insert hay-019
+insert hay-020
+insert hay-021
+insert hay-022
+insert hay-023
+insert hay-024
+insert hay-025
+insert hay-026
+insert hay-027
+insert hay-028
+insert hay-029
+insert hay-030
+insert hay-031
+insert hay-032
+insert hay-033
+insert hay-034
+insert hay-035
+insert hay-036
+insert hay-037
+insert hay-038
+insert hay-039
+insert hay-040
+insert hay-041
+insert hay-042
+insert hay-043
+insert hay-044
+insert hay-045
+insert hay-046
+insert hay-047
+insert hay-048
+insert hay-049
+insert hay-050
+insert hay-051
+insert hay-052
+insert hay-053
+insert hay-054
+insert hay-055
+insert hay-056
+insert hay-057
+insert hay-058
+insert hay-059
+insert hay-060
+insert hay-061
+insert hay-062
+insert needle-063
+insert needle-064
+insert needle-065
+insert hay-066
+insert hay-067
+insert hay-068
+insert hay-069
+insert hay-070
+insert hay-071
+insert hay-072
+insert hay-073
+insert hay-074
+insert hay-075
+insert hay-076
+insert hay-077
+insert hay-078
+insert hay-079
+insert hay-080
+insert hay-081
+insert hay-082
+insert hay-083
+insert hay-084
+insert hay-085
+insert hay-086
+insert hay-087
+insert hay-088
+insert hay-089
+insert hay-090
+insert hay-091
+insert hay-092
+insert hay-093
+insert hay-094
+insert hay-095
+insert hay-096
+insert hay-097
+insert hay-098
+insert hay-099
+insert hay-100
+insert hay-101
+insert hay-102
+insert hay-103
+insert hay-104
+insert hay-105
+insert hay-106
+insert hay-107
+insert hay-108
+insert hay-109
+insert hay-110
+insert hay-111
+insert hay-112
+insert hay-113
+insert hay-114
+insert hay-115
+insert hay-116
+insert hay-117
+insert hay-118
+insert hay-119
+insert hay-120
+insert hay-121
+insert hay-122
+insert hay-123
+insert hay-124
+insert hay-125
+insert hay-126
+insert needle-127
+insert needle-128
+insert hay-129
+insert hay-130
+insert hay-131
+insert hay-132
+insert hay-133
+insert hay-134
+insert hay-135
+insert hay-136
+insert hay-137
+insert hay-138
+insert hay-139
+insert hay-140
+insert hay-141
+insert hay-142
+insert hay-143
+insert hay-144
+insert hay-145
+insert hay-146
+insert hay-147
+insert hay-148
+insert needle-149
+insert a-b
+insert a}b
+insert école-#
+insert ECOLE_x
+insert abcdefghijklmnopqrstuvw-
+insert abcdefghijklmnopqrstuvwx-
+insert Z9-mixed
+count needle
+findfwd needle 2
+findfwd needle 3
+findfwd NEEDLE 5
+findrev needle 2
+findrev needle 4
+findall needle 10 2
+findmulti 6 needle -1
+count a-b
+count a}b
+findfwd }b 1
+findrev -b 2
+count #
+findfwd ÉCOLE 1
+findfwd école 2
+count ecole
+count abcdefghijklmnopqrstuvwx-
+findfwd ABCDEFGHIJKLMNOPQRSTUVW- 2
+count bcdefghijklmnopqrstuvw
+count z9-
+findfwd 9-M 1
+count z-
+count 148
+findrev 12 3
@@ -0,0 +1,29 @@
+insert one-a
+insert two-b
+insert  spaced out-c
+insert three-a
+insert four-b
+insert five-a
+insert Straße-x
+save words.txt
+--restart--
+threads 3
+load words.txt
+findfwd -a 1
+findfwd -a 3
+findfwd -a 4
+findrev -a 1
+findrev -a 3
+findrev -B 2
+count -
+findall -a
+showrev 4
+load words.txt
+count out
+findrev out 1
+findfwd STRAß 1
+threads 0
+threads 65
+threads two
+threads 1
+findfwd -b 4
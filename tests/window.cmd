@@ -0,0 +1,37 @@
+window 0
+window 3
+insert w-1
+insert w-2
+insert x-3
+insert w-4
+insert x-5
+count w
+count -
+findfwd w 1
+findfwd w 2
+findrev w 1
+findrev - 3
+findrev - 4
+findall -
+showrev 5
+findmulti 2 w x
+insert w-6
+insert w-7
+findfwd x 1
+count x
+save window.txt
+window off
+index on
+--restart--
+index on
+window 2
+index off
+intern on
+window 2
+--restart--
+compress on
+window 2
+compress off
+window 2
+load window.txt
+findall -
@@ -0,0 +1,342 @@
+// The pattern cache: the matches of recent patterns, kept up to date as
+// words are appended.
+
+#include "wordlist.h"
+
+void enableCache(WordList *list)
+{
+    if (list->cache.entries)
+    {
+        return;
+    }
+    PatternEntry *entries = (PatternEntry *)calloc(PATTERN_CACHE_SLOTS, sizeof(PatternEntry));
+    if (!entries)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    __atomic_store_n(&list->cache.entries, entries, __ATOMIC_RELAXED);
+}
+
+void freeCache(WordList *list)
+{
+    if (!list->cache.entries)
+    {
+        return;
+    }
+    for (int i = 0; i < PATTERN_CACHE_SLOTS; i++)
+    {
+        free(list->cache.entries[i].pattern);
+        free(list->cache.entries[i].matches);
+        free(list->cache.entries[i].tail);
+    }
+    free(list->cache.entries);
+    __atomic_store_n(&list->cache.entries, NULL, __ATOMIC_RELAXED);
+}
+
+// Forget the matches that slid out of a streaming window
+static void dropExpired(const WordList *list, PatternEntry *entry)
+{
+    if (entry->tailTo <= list->base)
+    {
+        entry->tailSize = 0;
+        entry->tailFrom = entry->tailTo = list->base;
+    }
+    else if (entry->tailFrom < list->base)
+    {
+        while (entry->tailSize > 0 && entry->tail[entry->tailSize - 1] < list->base)
+        {
+            entry->tailSize--;
+        }
+        entry->tailFrom = list->base;
+    }
+    if (entry->scanned <= list->base)
+    {
+        entry->size = 0;
+        entry->scanned = list->base;
+        return;
+    }
+    if (entry->size == 0 || entry->matches[0] >= list->base)
+    {
+        return;
+    }
+    int lo = 0, hi = entry->size;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (entry->matches[mid] < list->base) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo > 0)
+    {
+        memmove(entry->matches, entry->matches + lo, (entry->size - lo) * sizeof(int));
+        entry->size -= lo;
+    }
+}
+
+// Find the entry for pattern ignoring case, reusing the least recently used
+// slot (and its match buffer) when the pattern is not cached yet
+PatternEntry *lookupPattern(WordList *list, const char *pattern)
+{
+    PatternCache *cache = &list->cache;
+    size_t len = strlen(pattern);
+    PatternEntry *victim = &cache->entries[0];
+    for (int i = 0; i < PATTERN_CACHE_SLOTS; i++)
+    {
+        PatternEntry *entry = &cache->entries[i];
+        if (entry->pattern && strlen(entry->pattern) == len && equalFolded(entry->pattern, pattern, len))
+        {
+            entry->lastUsed = ++cache->clock;
+            list->stats.cacheHits++;
+            dropExpired(list, entry);
+            return entry;
+        }
+        if (!entry->pattern || (victim->pattern && entry->lastUsed < victim->lastUsed))
+        {
+            victim = entry;
+        }
+    }
+    free(victim->pattern);
+    victim->pattern = (char *)malloc(len + 1);
+    if (!victim->pattern)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i <= len; i++)
+    {
+        victim->pattern[i] = (char)foldByte((unsigned char)pattern[i]);
+    }
+    victim->size = 0;
+    victim->scanned = list->base;
+    victim->tailSize = 0;
+    victim->tailFrom = victim->tailTo = list->base;
+    victim->lastUsed = ++cache->clock;
+    return victim;
+}
+
+// Check the words [entry->scanned, end) in order, storing matches until the
+// entry holds `bound` of them. The index narrows the words checked when it
+// is enabled; otherwise a long range is split across the configured
+// threads, which always scan it to its end.
+static void scanAhead(WordList *list, PatternEntry *entry, const char *pattern, int end, int bound)
+{
+    MatchScan scan;
+    beginMatches(&scan, list, pattern, entry->scanned, end, 0);
+    int remaining = end - entry->scanned;
+    if (!scan.candidates && list->threads > 1 && remaining >= PARALLEL_MIN_WORDS)
+    {
+        int threads = list->threads;
+        ScanChunk chunks[MAX_THREADS];
+        for (int t = 0; t < threads; t++)
+        {
+            chunks[t].list = list;
+            chunks[t].pattern = pattern;
+            chunks[t].begin = entry->scanned + (int)((long long)remaining * t / threads);
+            chunks[t].end = entry->scanned + (int)((long long)remaining * (t + 1) / threads);
+            chunks[t].matches = NULL;
+            chunks[t].capacity = 0;
+        }
+        matchDistinct(list, pattern);
+        runChunks(chunks, sizeof(ScanChunk), threads, collectChunk);
+        // The entry then covers the words up to the first match it had no
+        // room for
+        int stop = end;
+        for (int t = 0; t < threads; t++)
+        {
+            for (int k = 0; k < chunks[t].count && stop == end; k++)
+            {
+                if (entry->size < bound)
+                {
+                    addMatch(&entry->matches, &entry->size, &entry->capacity, chunks[t].matches[k]);
+                }
+                else
+                {
+                    stop = chunks[t].matches[k];
+                }
+            }
+            free(chunks[t].matches);
+        }
+        list->stats.wordsScanned += remaining;
+        entry->scanned = stop;
+        return;
+    }
+    while (entry->size < bound)
+    {
+        int i = nextMatch(&scan);
+        if (i < 0)
+        {
+            break;
+        }
+        addMatch(&entry->matches, &entry->size, &entry->capacity, i);
+    }
+    list->stats.wordsScanned += matchScanWork(&scan);
+    entry->scanned = scan.frontier;
+}
+
+// Check words from entry->scanned onwards until the entry holds `want`
+// matches, covers the whole list or is full. A tail the scan runs into is
+// taken over whole, since its words are already checked.
+void extendPattern(WordList *list, PatternEntry *entry, const char *pattern, int want)
+{
+    while (entry->scanned < list->size)
+    {
+        int room = PATTERN_CACHE_MATCHES - entry->tailSize;
+        int bound = want < room ? want : room;
+        if (entry->size >= bound)
+        {
+            return;
+        }
+        int hasTail = entry->tailFrom < entry->tailTo;
+        if (hasTail && entry->scanned == entry->tailFrom)
+        {
+            for (int k = entry->tailSize - 1; k >= 0; k--)
+            {
+                addMatch(&entry->matches, &entry->size, &entry->capacity, entry->tail[k]);
+            }
+            entry->scanned = entry->tailTo;
+            entry->tailSize = 0;
+            entry->tailFrom = entry->tailTo;
+            continue;
+        }
+        int end = hasTail ? entry->tailFrom : list->size;
+        scanAhead(list, entry, pattern, end, bound);
+        if (entry->scanned < end)
+        {
+            return;
+        }
+    }
+}
+
+// A reverse findNth() through the entry's tail. The words inserted since
+// the tail was filled are checked first and added to it; the tail is then
+// carried back towards the prefix only as far as the nth match.
+static int findNthBackward(WordList *list, PatternEntry *entry, const char *pattern, int n)
+{
+    if (entry->tailFrom == entry->tailTo)
+    {
+        entry->tailSize = 0;
+        entry->tailFrom = entry->tailTo = list->size;
+    }
+    if (entry->tailTo < list->size)
+    {
+        int *fresh = NULL;
+        int freshSize = 0;
+        int freshCapacity = 0;
+        MatchScan scan;
+        beginMatches(&scan, list, pattern, entry->tailTo, list->size, 1);
+        for (int i = nextMatch(&scan); i >= 0; i = nextMatch(&scan))
+        {
+            addMatch(&fresh, &freshSize, &freshCapacity, i);
+        }
+        list->stats.wordsScanned += matchScanWork(&scan);
+        int stored = entry->size + entry->tailSize + freshSize <= PATTERN_CACHE_MATCHES;
+        if (stored)
+        {
+            if (entry->tailSize + freshSize > entry->tailCapacity)
+            {
+                entry->tailCapacity = entry->tailSize + freshSize;
+                entry->tail = (int *)realloc(entry->tail, entry->tailCapacity * sizeof(int));
+                if (!entry->tail)
+                {
+                    fprintf(stderr, "Memory reallocation failed\n");
+                    exit(1);
+                }
+            }
+            if (freshSize > 0)
+            {
+                memmove(entry->tail + freshSize, entry->tail, entry->tailSize * sizeof(int));
+                memcpy(entry->tail, fresh, freshSize * sizeof(int));
+            }
+            entry->tailSize += freshSize;
+            entry->tailTo = list->size;
+        }
+        else if (n <= freshSize)
+        {
+            int i = fresh[n - 1];
+            free(fresh);
+            return i;
+        }
+        else
+        {
+            // A full entry counts the new words' matches without keeping them
+            n -= freshSize;
+        }
+        free(fresh);
+    }
+    if (n > entry->tailSize && entry->tailFrom > entry->scanned)
+    {
+        MatchScan scan;
+        beginMatches(&scan, list, pattern, entry->scanned, entry->tailFrom, 1);
+        while (entry->tailSize < n && entry->size + entry->tailSize < PATTERN_CACHE_MATCHES)
+        {
+            int i = nextMatch(&scan);
+            if (i < 0)
+            {
+                break;
+            }
+            addMatch(&entry->tail, &entry->tailSize, &entry->tailCapacity, i);
+        }
+        list->stats.wordsScanned += matchScanWork(&scan);
+        entry->tailFrom = scan.frontier;
+    }
+    if (n <= entry->tailSize)
+    {
+        return entry->tail[n - 1];
+    }
+    n -= entry->tailSize;
+    // A full entry leaves a gap between the tail and the prefix
+    if (entry->tailFrom > entry->scanned)
+    {
+        int total;
+        int i = findNthInRange(list, pattern, entry->scanned, entry->tailFrom, n, 1, &total);
+        if (i >= 0)
+        {
+            return i;
+        }
+        n -= total;
+    }
+    return n <= entry->size ? entry->matches[entry->size - n] : -1;
+}
+
+// findNth() through the pattern cache. A forward query scans as far as the
+// nth match and a reverse one back as far as its match; repeating either
+// only checks the words inserted since. Matches past a full entry are found
+// by scanning on without storing them.
+int findNthCached(WordList *list, const char *pattern, int n, int reverse)
+{
+    PatternEntry *entry = lookupPattern(list, pattern);
+    if (reverse)
+    {
+        return findNthBackward(list, entry, pattern, n);
+    }
+    extendPattern(list, entry, pattern, n);
+    if (n <= entry->size)
+    {
+        return entry->matches[n - 1];
+    }
+    if (entry->scanned >= list->size)
+    {
+        return -1;
+    }
+    int total;
+    return findNthInRange(list, pattern, entry->scanned, list->size, n - entry->size, 0, &total);
+}
+
+void setCache(WordList *list, const char *mode)
+{
+    if (strcmp(mode, "on") == 0)
+    {
+        enableCache(list);
+        reply("Pattern cache enabled (%d patterns).\n", PATTERN_CACHE_SLOTS);
+    }
+    else if (strcmp(mode, "off") == 0)
+    {
+        freeCache(list);
+        reply("Pattern cache disabled.\n");
+    }
+    else
+    {
+        replyError("Error: Invalid cache mode '%s' (expected on/off)\n", mode);
+    }
+}
@@ -0,0 +1,344 @@
+// Command output, the command table and the dispatcher.
+
+#include "wordlist.h"
+
+// Command output goes to stdout, or to the client a server thread is serving
+__thread FILE *replyStream;
+
+FILE *replyFile(void)
+{
+    return replyStream ? replyStream : stdout;
+}
+
+void reply(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(replyFile(), format, args);
+    va_end(args);
+}
+
+// Errors go with the rest of the output, except in quiet mode, where they go
+// to stderr so stdout carries only results. A client always gets its errors.
+int quietErrors;
+
+void replyError(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(replyStream ? replyStream : quietErrors ? stderr : stdout, format, args);
+    va_end(args);
+}
+
+// Quiet mode drops the prompt and the per-word echo and errors of loads, and
+// sends command errors to stderr; load summaries still print
+void setQuiet(WordList *list, const char *mode)
+{
+    if (strcmp(mode, "on") == 0)
+    {
+        list->quiet = 1;
+        quietErrors = 1;
+        reply("Quiet mode enabled.\n");
+    }
+    else if (strcmp(mode, "off") == 0)
+    {
+        list->quiet = 0;
+        quietErrors = 0;
+        reply("Quiet mode disabled.\n");
+    }
+    else
+    {
+        replyError("Error: Invalid quiet mode '%s' (expected on/off)\n", mode);
+    }
+}
+
+static const Command commands[] = {
+    {"insert", ARGS_TEXT, STAT_INSERT, 0, insert, NULL, NULL, NULL},
+    {"findfwd", ARGS_PATTERN_COUNT, STAT_FINDFWD, 1, NULL, findfwd, NULL, NULL},
+    {"findrev", ARGS_PATTERN_COUNT, STAT_FINDREV, 1, NULL, findrev, NULL, NULL},
+    {"findall", ARGS_PATTERN_RANGE, STAT_FINDALL, 1, NULL, NULL, NULL, findall},
+    {"count", ARGS_PATTERN, STAT_COUNT, 1, count, NULL, NULL, NULL},
+    {"findmulti", ARGS_COUNT_PATTERNS, STAT_FINDMULTI, 1, NULL, findmulti, NULL, NULL},
+    {"findmultirev", ARGS_COUNT_PATTERNS, STAT_FINDMULTIREV, 1, NULL, findmultirev, NULL, NULL},
+    {"showrev", ARGS_COUNT, STAT_SHOWREV, 1, NULL, NULL, showrev, NULL},
+    {"load", ARGS_TEXT, STAT_LOAD, 0, load, NULL, NULL, NULL},
+    {"loadbin", ARGS_TEXT, STAT_LOADBIN, 0, loadbin, NULL, NULL, NULL},
+    {"save", ARGS_TEXT, STAT_SAVE, 0, save, NULL, NULL, NULL},
+    {"savebin", ARGS_TEXT, STAT_SAVEBIN, 0, savebin, NULL, NULL, NULL},
+    {"journal", ARGS_TEXT, -1, 0, journal, NULL, NULL, NULL},
+    {"compact", ARGS_NONE, -1, 0, compact, NULL, NULL, NULL},
+    {"index", ARGS_TEXT, -1, 0, setIndex, NULL, NULL, NULL},
+    {"threads", ARGS_TEXT, -1, 0, setThreads, NULL, NULL, NULL},
+    {"window", ARGS_TEXT, -1, 0, setWindow, NULL, NULL, NULL},
+    {"intern", ARGS_TEXT, -1, 0, setIntern, NULL, NULL, NULL},
+    {"compress", ARGS_TEXT, -1, 0, setCompress, NULL, NULL, NULL},
+    {"cache", ARGS_TEXT, -1, 0, setCache, NULL, NULL, NULL},
+    {"quiet", ARGS_TEXT, -1, 0, setQuiet, NULL, NULL, NULL},
+    {"stats", ARGS_OPTIONAL_TEXT, -1, 0, statsCommand, NULL, NULL, NULL},
+};
+
+const Command *lookupCommand(const char *name, size_t len)
+{
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+    {
+        if (strncmp(commands[i].name, name, len) == 0 && commands[i].name[len] == 0)
+        {
+            return &commands[i];
+        }
+    }
+    return NULL;
+}
+
+// Parse the integer text starts with and ignore whatever follows it, as
+// the original sscanf("%d") did for findfwd, findrev and showrev. Returns
+// the end of the integer, or NULL if there is none.
+const char *parseLeadingCount(const char *text, int *n)
+{
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || errno != 0 || value < INT32_MIN || value > INT32_MAX)
+    {
+        return NULL;
+    }
+    *n = (int)value;
+    return end;
+}
+
+// Parse a whole-token integer, allowing only trailing whitespace
+int parseCount(const char *text, int *n)
+{
+    const char *end = parseLeadingCount(text, n);
+    if (!end)
+    {
+        return 0;
+    }
+    while (isspace((unsigned char)*end)) end++;
+    return *end == 0;
+}
+
+// Parse the integer token [text, end) without writing into the line
+int parseCountToken(const char *text, const char *end, int *n)
+{
+    char token[24];
+    if (end - text >= (long)sizeof(token))
+    {
+        return 0;
+    }
+    memcpy(token, text, end - text);
+    token[end - text] = 0;
+    return parseCount(token, n);
+}
+
+// Split one command line into its command and arguments in a single pass
+// and run it through the command table. Returns 1 when the line is 'exit'.
+int dispatchLine(WordList *list, char *line)
+{
+    char *trimmed_line = trim(line);
+    if (strlen(trimmed_line) == 0)
+    {
+        replyError("Error: Empty command\n");
+        return 0;
+    }
+    if (strcmp(trimmed_line, "exit") == 0)
+    {
+        return 1;
+    }
+    char *name = trimmed_line;
+    char *args = name;
+    while (*args && !isspace((unsigned char)*args)) args++;
+    const Command *command = lookupCommand(name, args - name);
+    while (isspace((unsigned char)*args)) args++;
+
+    // Arguments are checked before anything is written into the line, so
+    // a rejected line can still be echoed whole
+    int valid = command != NULL;
+    char *pattern_end = args;
+    char *rest = args;
+    int n = INT32_MAX;
+    int offset = 0;
+    if (valid)
+    {
+        switch (command->args)
+        {
+        case ARGS_NONE:
+            valid = *args == 0;
+            break;
+        case ARGS_TEXT:
+            valid = *args != 0;
+            break;
+        case ARGS_OPTIONAL_TEXT:
+            break;
+        case ARGS_PATTERN:
+            while (*pattern_end && !isspace((unsigned char)*pattern_end)) pattern_end++;
+            rest = pattern_end;
+            while (isspace((unsigned char)*rest)) rest++;
+            valid = pattern_end > args && *rest == 0;
+            break;
+        case ARGS_PATTERN_RANGE:
+            // Optional limit and offset follow the pattern
+            while (*pattern_end && !isspace((unsigned char)*pattern_end)) pattern_end++;
+            valid = pattern_end > args;
+            rest = pattern_end;
+            while (valid && isspace((unsigned char)*rest)) rest++;
+            if (valid && *rest)
+            {
+                char *second = rest;
+                while (*second && !isspace((unsigned char)*second)) second++;
+                char *offsetText = second;
+                while (isspace((unsigned char)*offsetText)) offsetText++;
+                valid = parseCountToken(rest, second, &n) && (*offsetText == 0 || parseCount(offsetText, &offset));
+            }
+            break;
+        case ARGS_PATTERN_COUNT:
+            while (*pattern_end && !isspace((unsigned char)*pattern_end)) pattern_end++;
+            valid = pattern_end > args && parseLeadingCount(pattern_end, &n) != NULL;
+            break;
+        case ARGS_COUNT:
+            valid = parseLeadingCount(args, &n) != NULL;
+            break;
+        case ARGS_COUNT_PATTERNS:
+            // The count comes first, then one or more patterns
+            while (*pattern_end && !isspace((unsigned char)*pattern_end)) pattern_end++;
+            rest = pattern_end;
+            while (isspace((unsigned char)*rest)) rest++;
+            valid = parseCountToken(args, pattern_end, &n) && *rest != 0;
+            break;
+        }
+    }
+    if (!valid)
+    {
+        replyError("Invalid command: %s\n", trimmed_line);
+        return 0;
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    switch (command->args)
+    {
+    case ARGS_NONE:
+    case ARGS_TEXT:
+    case ARGS_OPTIONAL_TEXT:
+        command->withText(list, args);
+        break;
+    case ARGS_PATTERN:
+        *pattern_end = 0;
+        command->withText(list, args);
+        break;
+    case ARGS_PATTERN_COUNT:
+        *pattern_end = 0;
+        command->withPatternCount(list, args, n);
+        break;
+    case ARGS_PATTERN_RANGE:
+        *pattern_end = 0;
+        command->withPatternRange(list, args, n, offset);
+        break;
+    case ARGS_COUNT:
+        command->withCount(list, n);
+        break;
+    case ARGS_COUNT_PATTERNS:
+        command->withPatternCount(list, rest, n);
+        break;
+    }
+    recordLatency(list, command->stat, &started);
+    return 0;
+}
+
+// Replay a command file (or stdin for "-") with large reads and no prompts
+int runBatch(WordList *list, const char *path)
+{
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open command file '%s'.\n", path);
+        return 1;
+    }
+    char *buffer = (char *)malloc(BATCH_BUFFER_SIZE + 1);
+    if (!buffer)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    size_t used = 0;
+    int done = 0;
+    int skipping = 0;
+    while (!done)
+    {
+        ssize_t got = read(fd, buffer + used, BATCH_BUFFER_SIZE - used);
+        if (got < 0)
+        {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error reading command file '%s'.\n", path);
+            break;
+        }
+        used += (size_t)got;
+        char *line = buffer;
+        char *end = buffer + used;
+        char *newline;
+        while (!done && (newline = (char *)memchr(line, '\n', end - line)) != NULL)
+        {
+            *newline = 0;
+            if (!skipping)
+            {
+                done = dispatchLine(list, line);
+            }
+            skipping = 0;
+            line = newline + 1;
+        }
+        journalCommit(list);
+        used = end - line;
+        memmove(buffer, line, used);
+        if (got == 0)
+        {
+            // Last line without a newline
+            if (!done && used > 0 && !skipping)
+            {
+                buffer[used] = 0;
+                dispatchLine(list, buffer);
+            }
+            break;
+        }
+        if (used == BATCH_BUFFER_SIZE)
+        {
+            replyError("Error: Command line longer than %d bytes skipped\n", BATCH_BUFFER_SIZE);
+            used = 0;
+            skipping = 1;
+        }
+    }
+    free(buffer);
+    if (fd != STDIN_FILENO)
+    {
+        close(fd);
+    }
+    return 0;
+}
+
+void printGuidance()
+{
+    reply("\nAvailable commands:\n");
+    reply("  insert <word/phrase>         : Insert a word or phrase into the list\n");
+    reply("  findfwd <pattern> <n>        : Find the nth occurrence of pattern (forward)\n");
+    reply("  findrev <pattern> <n>        : Find the nth occurrence of pattern (reverse)\n");
+    reply("  findall <pattern> [n [skip]] : List occurrences of pattern (n at most, after skip)\n");
+    reply("  count <pattern>              : Count the words containing pattern\n");
+    reply("  findmulti <n> <patterns>     : Find the nth occurrence of each pattern in one scan\n");
+    reply("  findmultirev <n> <patterns>  : The same, counting from the end\n");
+    reply("  showrev <n>                  : Show last n words in reverse alphabetical order\n");
+    reply("  load <filename>              : Load words from a file\n");
+    reply("  save <filename>              : Save word list to a file\n");
+    reply("  savebin <filename>           : Save word list as a binary snapshot\n");
+    reply("  loadbin <filename>           : Load words from a binary snapshot\n");
+    reply("  journal <file> [sync]|off    : Replay file and file.log, then log every new word\n");
+    reply("                                 (sync: always, periodic or none)\n");
+    reply("  compact                      : Fold the journal's log into its snapshot\n");
+    reply("  index <on|off>               : Toggle the trigram substring index\n");
+    reply("  threads <n>                  : Scan large lists and load files with n threads\n");
+    reply("  window <n|off>               : Keep only the last n words (set while empty)\n");
+    reply("  intern <on|off>              : Store repeated words once (set while empty)\n");
+    reply("  compress <on|off>            : Store words front-coded in blocks (set while empty)\n");
+    reply("  cache <on|off>               : Toggle the cache of repeated find patterns\n");
+    reply("  quiet <on|off>               : Stop echoing inserted words and the prompt\n");
+    reply("                                 (errors then go to stderr)\n");
+    reply("  stats [json|reset]           : Show command counts, latencies and I/O totals\n");
+    reply("  exit                         : Quit the program\n");
+}
@@ -0,0 +1,404 @@
+// findfwd, findrev, findall and count, scanning the list from one thread
+// or several.
+
+#include "wordlist.h"
+
+int countMatches(const WordList *list, const char *pattern, int begin, int end)
+{
+    int count = 0;
+    CandidateScan scan;
+    beginCandidates(&scan, list, begin, end, 0);
+    for (int i = nextCandidate(&scan); i >= 0; i = nextCandidate(&scan))
+    {
+        if (wordMatches(list, i, pattern))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Index of the nth word in [begin, end) containing pattern, counting from the
+// front (or from the back when reverse is set), or -1 if there are fewer
+int nthMatchInRange(const WordList *list, const char *pattern, int begin, int end, int n, int reverse)
+{
+    int count = 0;
+    CandidateScan scan;
+    beginCandidates(&scan, list, begin, end, reverse);
+    for (int i = nextCandidate(&scan); i >= 0; i = nextCandidate(&scan))
+    {
+        if (wordMatches(list, i, pattern) && ++count == n)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void *countChunk(void *arg)
+{
+    ScanChunk *chunk = (ScanChunk *)arg;
+    chunk->count = countMatches(chunk->list, chunk->pattern, chunk->begin, chunk->end);
+    return NULL;
+}
+
+// Run worker on each of the chunkSize-byte chunks, one thread each. The
+// calling thread takes the first chunk, and any chunk whose thread failed
+// to start.
+void runChunks(void *chunks, size_t chunkSize, int threads, void *(*worker)(void *))
+{
+    pthread_t workers[MAX_THREADS];
+    int started[MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+        void *chunk = (char *)chunks + t * chunkSize;
+        started[t] = t > 0 && pthread_create(&workers[t], NULL, worker, chunk) == 0;
+    }
+    for (int t = 0; t < threads; t++)
+    {
+        if (!started[t])
+        {
+            worker((char *)chunks + t * chunkSize);
+        }
+    }
+    for (int t = 1; t < threads; t++)
+    {
+        if (started[t])
+        {
+            pthread_join(workers[t], NULL);
+        }
+    }
+}
+
+// Start a find of the folded pattern: the list notes the pattern's
+// signature, and the interned words' memo is invalidated by moving to a new
+// epoch, and only cleared when the epochs run out
+void beginMatch(WordList *list, const char *pattern)
+{
+    InternTable *intern = &list->intern;
+    list->need = wordSignature(pattern);
+    if (!list->ids)
+    {
+        return;
+    }
+    if (++intern->epoch >= 1u << 31)
+    {
+        memset(intern->memo, 0, intern->capacity * sizeof(uint32_t));
+        intern->epoch = 1;
+    }
+}
+
+static void *matchDistinctChunk(void *arg)
+{
+    ScanChunk *chunk = (ScanChunk *)arg;
+    const WordList *list = chunk->list;
+    for (int d = chunk->begin; d < chunk->end; d++)
+    {
+        int matched = (*signatureSlot(list, d) & list->need) == list->need &&
+                      strcasestr(*foldSlot(list, d), chunk->pattern) != NULL;
+        list->intern.memo[d] = list->intern.epoch << 1 | matched;
+    }
+    return NULL;
+}
+
+// Test every distinct word of an interned list against pattern up front,
+// split across the threads. The memo is then only read, so the threads of
+// a parallel scan can share it.
+void matchDistinct(WordList *list, const char *pattern)
+{
+    if (!list->ids)
+    {
+        return;
+    }
+    int distinct = list->intern.size;
+    int threads = distinct >= PARALLEL_MIN_WORDS ? list->threads : 1;
+    ScanChunk chunks[MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+        chunks[t].list = list;
+        chunks[t].pattern = pattern;
+        chunks[t].begin = (int)((long long)distinct * t / threads);
+        chunks[t].end = (int)((long long)distinct * (t + 1) / threads);
+    }
+    runChunks(chunks, sizeof(ScanChunk), threads, matchDistinctChunk);
+}
+
+// Split [begin, end) into one chunk per thread and count matches in each
+// concurrently. Walking the per-chunk counts in scan order then tells which
+// chunk holds the nth match, and only that chunk is scanned again to pin
+// down the exact index, so the answer matches the serial loop. With fewer
+// matches, *total is set to how many there are.
+int findNthParallel(WordList *list, const char *pattern, int begin, int end, int n, int reverse, int *total)
+{
+    int threads = list->threads;
+    int words = end - begin;
+    ScanChunk chunks[MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+        chunks[t].list = list;
+        chunks[t].pattern = pattern;
+        chunks[t].begin = begin + (int)((long long)words * t / threads);
+        chunks[t].end = begin + (int)((long long)words * (t + 1) / threads);
+    }
+    matchDistinct(list, pattern);
+    runChunks(chunks, sizeof(ScanChunk), threads, countChunk);
+
+    list->stats.wordsScanned += words;
+    int before = 0;
+    for (int k = 0; k < threads; k++)
+    {
+        const ScanChunk *chunk = &chunks[reverse ? threads - 1 - k : k];
+        if (before + chunk->count >= n)
+        {
+            int i = nthMatchInRange(list, pattern, chunk->begin, chunk->end, n - before, reverse);
+            list->stats.wordsScanned += reverse ? chunk->end - i : i - chunk->begin + 1;
+            return i;
+        }
+        before += chunk->count;
+    }
+    *total = before;
+    return -1;
+}
+
+// Index of the nth word in [begin, end) containing the folded pattern,
+// counting from the front (or from the back when reverse is set). With
+// fewer matches, returns -1 and sets *total to how many there are. Only the
+// index's candidates are checked when it is enabled; otherwise a large
+// range is scanned on several threads when that is configured.
+int findNthInRange(WordList *list, const char *pattern, int begin, int end, int n, int reverse, int *total)
+{
+    MatchScan scan;
+    beginMatches(&scan, list, pattern, begin, end, reverse);
+    // Below this size starting the threads costs more than the scan itself
+    if (!scan.candidates && list->threads > 1 && end - begin >= PARALLEL_MIN_WORDS)
+    {
+        return findNthParallel(list, pattern, begin, end, n, reverse, total);
+    }
+    int count = 0;
+    for (int i = nextMatch(&scan); i >= 0; i = nextMatch(&scan))
+    {
+        if (++count == n)
+        {
+            list->stats.wordsScanned += matchScanWork(&scan);
+            return i;
+        }
+    }
+    list->stats.wordsScanned += matchScanWork(&scan);
+    *total = count;
+    return -1;
+}
+
+// Return the index of the nth word containing the folded pattern, counting
+// from the front (or from the back when reverse is set), or -1 if there is
+// none, through the pattern cache when it is enabled.
+int findNthFolded(WordList *list, const char *pattern, int n, int reverse)
+{
+    list->stats.finds++;
+    beginMatch(list, pattern);
+    if (list->cache.entries)
+    {
+        return findNthCached(list, pattern, n, reverse);
+    }
+    int total;
+    return findNthInRange(list, pattern, list->base, list->size, n, reverse, &total);
+}
+
+int findNth(WordList *list, const char *pattern, int n, int reverse)
+{
+    char buffer[FOLD_BUFFER_SIZE];
+    char *folded = foldPattern(pattern, buffer);
+    int i = findNthFolded(list, folded, n, reverse);
+    if (folded != buffer)
+    {
+        free(folded);
+    }
+    return i;
+}
+
+void addMatch(int **matches, int *size, int *capacity, int id)
+{
+    if (*size >= *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 16;
+        *matches = (int *)realloc(*matches, *capacity * sizeof(int));
+        if (!*matches)
+        {
+            fprintf(stderr, "Memory reallocation failed\n");
+            exit(1);
+        }
+    }
+    (*matches)[(*size)++] = id;
+}
+
+void *collectChunk(void *arg)
+{
+    ScanChunk *chunk = (ScanChunk *)arg;
+    chunk->count = 0;
+    CandidateScan scan;
+    beginCandidates(&scan, chunk->list, chunk->begin, chunk->end, 0);
+    for (int i = nextCandidate(&scan); i >= 0; i = nextCandidate(&scan))
+    {
+        if (wordMatches(chunk->list, i, chunk->pattern))
+        {
+            addMatch(&chunk->matches, &chunk->count, &chunk->capacity, i);
+        }
+    }
+    return NULL;
+}
+
+void findfwd(WordList *list, const char *pattern, int n)
+{
+    if (n <= 0)
+    {
+        replyError("Error: Invalid occurrence number %d\n", n);
+        return;
+    }
+    int i = findNth(list, pattern, n, 0);
+    if (i >= 0)
+    {
+        reply("Found '%s' at index %d: %s\n", pattern, i - list->base, wordAt(list, i));
+        return;
+    }
+    reply("No %dth occurrence of '%s' found.\n", n, pattern);
+}
+
+void findrev(WordList *list, const char *pattern, int n)
+{
+    if (n <= 0)
+    {
+        replyError("Error: Invalid occurrence number %d\n", n);
+        return;
+    }
+    int i = findNth(list, pattern, n, 1);
+    if (i >= 0)
+    {
+        reply("Found '%s' at index %d: %s\n", pattern, i - list->base, wordAt(list, i));
+        return;
+    }
+    reply("No %dth occurrence of '%s' found.\n", n, pattern);
+}
+
+static void printMatch(const WordList *list, int i, int offset, int limit, int *seen)
+{
+    if (*seen >= offset && *seen - offset < limit)
+    {
+        reply("%d: %s\n", i - list->base, wordAt(list, i));
+    }
+    (*seen)++;
+}
+
+// Visit the matches of the folded pattern in index order in one pass,
+// printing those numbered [offset, offset + limit) when print is set.
+// Returns how many matches were visited: the total when limit is unbounded,
+// else at most offset + limit. Goes through the same pattern cache, index
+// and threads as findNth(), and past the cached matches allocates nothing
+// per match.
+int scanFolded(WordList *list, const char *pattern, int offset, int limit, int print)
+{
+    int want = limit > INT32_MAX - offset ? INT32_MAX : offset + limit;
+    int seen = 0;
+    int begin = list->base;
+    list->stats.finds++;
+    beginMatch(list, pattern);
+    if (list->cache.entries)
+    {
+        PatternEntry *entry = lookupPattern(list, pattern);
+        extendPattern(list, entry, pattern, want);
+        seen = entry->size < want ? entry->size : want;
+        for (int k = offset; print && k < seen; k++)
+        {
+            reply("%d: %s\n", entry->matches[k] - list->base, wordAt(list, entry->matches[k]));
+        }
+        if (seen == want || entry->scanned >= list->size)
+        {
+            return seen;
+        }
+        // The entry is full; the words past it are visited without storing
+        begin = entry->scanned;
+    }
+    MatchScan scan;
+    beginMatches(&scan, list, pattern, begin, list->size, 0);
+    if (!scan.candidates && !print && want == INT32_MAX)
+    {
+        // An interned list is counted from its distinct words' occurrences
+        if (list->ids && begin == list->base)
+        {
+            matchDistinct(list, pattern);
+            for (int d = 0; d < list->intern.size; d++)
+            {
+                if (list->intern.memo[d] & 1)
+                {
+                    seen += list->intern.counts[d];
+                }
+            }
+            list->stats.wordsScanned += list->intern.size;
+            return seen;
+        }
+        // A count over a large range splits the scan across the threads
+        int words = list->size - begin;
+        if (list->threads > 1 && words >= PARALLEL_MIN_WORDS)
+        {
+            ScanChunk chunks[MAX_THREADS];
+            for (int t = 0; t < list->threads; t++)
+            {
+                chunks[t].list = list;
+                chunks[t].pattern = pattern;
+                chunks[t].begin = begin + (int)((long long)words * t / list->threads);
+                chunks[t].end = begin + (int)((long long)words * (t + 1) / list->threads);
+            }
+            matchDistinct(list, pattern);
+            runChunks(chunks, sizeof(ScanChunk), list->threads, countChunk);
+            for (int t = 0; t < list->threads; t++)
+            {
+                seen += chunks[t].count;
+            }
+            list->stats.wordsScanned += words;
+            return seen;
+        }
+    }
+    while (seen < want)
+    {
+        int i = nextMatch(&scan);
+        if (i < 0)
+        {
+            break;
+        }
+        if (print) printMatch(list, i, offset, limit, &seen);
+        else seen++;
+    }
+    list->stats.wordsScanned += matchScanWork(&scan);
+    return seen;
+}
+
+int scanMatches(WordList *list, const char *pattern, int offset, int limit, int print)
+{
+    char buffer[FOLD_BUFFER_SIZE];
+    char *folded = foldPattern(pattern, buffer);
+    int seen = scanFolded(list, folded, offset, limit, print);
+    if (folded != buffer)
+    {
+        free(folded);
+    }
+    return seen;
+}
+
+void findall(WordList *list, const char *pattern, int limit, int offset)
+{
+    if (limit <= 0 || offset < 0)
+    {
+        replyError("Error: Invalid limit or offset\n");
+        return;
+    }
+    int seen = scanMatches(list, pattern, offset, limit, 1);
+    if (seen <= offset)
+    {
+        reply("No occurrences of '%s' found.\n", pattern);
+        return;
+    }
+    reply("Listed %d occurrences of '%s'.\n", seen - offset, pattern);
+}
+
+void count(WordList *list, const char *pattern)
+{
+    reply("Found %d occurrences of '%s'.\n", scanMatches(list, pattern, 0, INT32_MAX, 0), pattern);
+}
@@ -0,0 +1,397 @@
+// Case folding (ASCII and Unicode simple folding) and the word signatures
+// that let scans skip words without reading them.
+
+#include "wordlist.h"
+
+int strcasecmp(const char *s1, const char *s2)
+{
+    while (*s1 && *s2)
+    {
+        if (tolower((unsigned char)*s1) != tolower((unsigned char)*s2))
+        {
+            return tolower((unsigned char)*s1) - tolower((unsigned char)*s2);
+        }
+        s1++;
+        s2++;
+    }
+    return tolower((unsigned char)*s1) - tolower((unsigned char)*s2);
+}
+
+char *strcasestr(const char *haystack, const char *needle)
+{
+    if (!*needle) return (char *)haystack;
+    size_t nlen = strlen(needle);
+    size_t hlen = strlen(haystack);
+    if (hlen < nlen) return NULL;
+    return searchFolded(haystack, hlen, needle, nlen);
+}
+
+// The signature kernels set bit k of their result for each of the n <= 64
+// signatures that has every bit of need
+uint64_t signaturesScalar(const uint64_t *signatures, int n, uint64_t need)
+{
+    uint64_t bits = 0;
+    for (int k = 0; k < n; k++)
+    {
+        bits |= (uint64_t)((signatures[k] & need) == need) << k;
+    }
+    return bits;
+}
+
+#ifdef WORDLIST_X86_SIMD
+// SSE2 has no 64-bit compare, so a lane matches when both its halves do
+uint64_t signaturesSse2(const uint64_t *signatures, int n, uint64_t need)
+{
+    const __m128i wanted = _mm_set1_epi64x((long long)need);
+    uint64_t bits = 0;
+    int k = 0;
+    for (; k + 2 <= n; k += 2)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(signatures + k));
+        __m128i halves = _mm_cmpeq_epi32(_mm_and_si128(block, wanted), wanted);
+        __m128i lanes = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        bits |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(lanes)) << k;
+    }
+    return k < n ? bits | signaturesScalar(signatures + k, n - k, need) << k : bits;
+}
+
+__attribute__((target("avx2")))
+uint64_t signaturesAvx2(const uint64_t *signatures, int n, uint64_t need)
+{
+    const __m256i wanted = _mm256_set1_epi64x((long long)need);
+    uint64_t bits = 0;
+    int k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(signatures + k));
+        __m256i lanes = _mm256_cmpeq_epi64(_mm256_and_si256(block, wanted), wanted);
+        bits |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(lanes)) << k;
+    }
+    _mm256_zeroupper();
+    return k < n ? bits | signaturesSse2(signatures + k, n - k, need) << k : bits;
+}
+#endif
+
+static uint64_t selectSignatureKernel(const uint64_t *signatures, int n, uint64_t need);
+uint64_t (*signatureKernel)(const uint64_t *, int, uint64_t) = selectSignatureKernel;
+
+static uint64_t selectSignatureKernel(const uint64_t *signatures, int n, uint64_t need)
+{
+#ifdef WORDLIST_X86_SIMD
+    __builtin_cpu_init();
+    __atomic_store_n(&signatureKernel, __builtin_cpu_supports("avx2") ? signaturesAvx2 : signaturesSse2, __ATOMIC_RELAXED);
+#else
+    __atomic_store_n(&signatureKernel, signaturesScalar, __ATOMIC_RELAXED);
+#endif
+    return __atomic_load_n(&signatureKernel, __ATOMIC_RELAXED)(signatures, n, need);
+}
+
+// Unicode simple case folding outside ASCII (CaseFolding.txt statuses C
+// and S, Unicode 14), as runs of code points folding by the same delta
+static const CaseRange caseRanges[] = {
+    {0x00B5, 0x00B5, 775, 1}, {0x00C0, 0x00D6, 32, 1}, {0x00D8, 0x00DE, 32, 1},
+    {0x0100, 0x012E, 1, 2}, {0x0132, 0x0136, 1, 2}, {0x0139, 0x0147, 1, 2},
+    {0x014A, 0x0176, 1, 2}, {0x0178, 0x0178, -121, 1}, {0x0179, 0x017D, 1, 2},
+    {0x017F, 0x017F, -268, 1}, {0x0181, 0x0181, 210, 1}, {0x0182, 0x0184, 1, 2},
+    {0x0186, 0x0186, 206, 1}, {0x0187, 0x0187, 1, 1}, {0x0189, 0x018A, 205, 1},
+    {0x018B, 0x018B, 1, 1}, {0x018E, 0x018E, 79, 1}, {0x018F, 0x018F, 202, 1},
+    {0x0190, 0x0190, 203, 1}, {0x0191, 0x0191, 1, 1}, {0x0193, 0x0193, 205, 1},
+    {0x0194, 0x0194, 207, 1}, {0x0196, 0x0196, 211, 1}, {0x0197, 0x0197, 209, 1},
+    {0x0198, 0x0198, 1, 1}, {0x019C, 0x019C, 211, 1}, {0x019D, 0x019D, 213, 1},
+    {0x019F, 0x019F, 214, 1}, {0x01A0, 0x01A4, 1, 2}, {0x01A6, 0x01A6, 218, 1},
+    {0x01A7, 0x01A7, 1, 1}, {0x01A9, 0x01A9, 218, 1}, {0x01AC, 0x01AC, 1, 1},
+    {0x01AE, 0x01AE, 218, 1}, {0x01AF, 0x01AF, 1, 1}, {0x01B1, 0x01B2, 217, 1},
+    {0x01B3, 0x01B5, 1, 2}, {0x01B7, 0x01B7, 219, 1}, {0x01B8, 0x01B8, 1, 1},
+    {0x01BC, 0x01BC, 1, 1}, {0x01C4, 0x01C4, 2, 1}, {0x01C5, 0x01C5, 1, 1},
+    {0x01C7, 0x01C7, 2, 1}, {0x01C8, 0x01C8, 1, 1}, {0x01CA, 0x01CA, 2, 1},
+    {0x01CB, 0x01DB, 1, 2}, {0x01DE, 0x01EE, 1, 2}, {0x01F1, 0x01F1, 2, 1},
+    {0x01F2, 0x01F4, 1, 2}, {0x01F6, 0x01F6, -97, 1}, {0x01F7, 0x01F7, -56, 1},
+    {0x01F8, 0x021E, 1, 2}, {0x0220, 0x0220, -130, 1}, {0x0222, 0x0232, 1, 2},
+    {0x023A, 0x023A, 10795, 1}, {0x023B, 0x023B, 1, 1}, {0x023D, 0x023D, -163, 1},
+    {0x023E, 0x023E, 10792, 1}, {0x0241, 0x0241, 1, 1}, {0x0243, 0x0243, -195, 1},
+    {0x0244, 0x0244, 69, 1}, {0x0245, 0x0245, 71, 1}, {0x0246, 0x024E, 1, 2},
+    {0x0345, 0x0345, 116, 1}, {0x0370, 0x0372, 1, 2}, {0x0376, 0x0376, 1, 1},
+    {0x037F, 0x037F, 116, 1}, {0x0386, 0x0386, 38, 1}, {0x0388, 0x038A, 37, 1},
+    {0x038C, 0x038C, 64, 1}, {0x038E, 0x038F, 63, 1}, {0x0391, 0x03A1, 32, 1},
+    {0x03A3, 0x03AB, 32, 1}, {0x03C2, 0x03C2, 1, 1}, {0x03CF, 0x03CF, 8, 1},
+    {0x03D0, 0x03D0, -30, 1}, {0x03D1, 0x03D1, -25, 1}, {0x03D5, 0x03D5, -15, 1},
+    {0x03D6, 0x03D6, -22, 1}, {0x03D8, 0x03EE, 1, 2}, {0x03F0, 0x03F0, -54, 1},
+    {0x03F1, 0x03F1, -48, 1}, {0x03F4, 0x03F4, -60, 1}, {0x03F5, 0x03F5, -64, 1},
+    {0x03F7, 0x03F7, 1, 1}, {0x03F9, 0x03F9, -7, 1}, {0x03FA, 0x03FA, 1, 1},
+    {0x03FD, 0x03FF, -130, 1}, {0x0400, 0x040F, 80, 1}, {0x0410, 0x042F, 32, 1},
+    {0x0460, 0x0480, 1, 2}, {0x048A, 0x04BE, 1, 2}, {0x04C0, 0x04C0, 15, 1},
+    {0x04C1, 0x04CD, 1, 2}, {0x04D0, 0x052E, 1, 2}, {0x0531, 0x0556, 48, 1},
+    {0x10A0, 0x10C5, 7264, 1}, {0x10C7, 0x10C7, 7264, 1}, {0x10CD, 0x10CD, 7264, 1},
+    {0x13F8, 0x13FD, -8, 1}, {0x1C80, 0x1C80, -6222, 1}, {0x1C81, 0x1C81, -6221, 1},
+    {0x1C82, 0x1C82, -6212, 1}, {0x1C83, 0x1C84, -6210, 1}, {0x1C85, 0x1C85, -6211, 1},
+    {0x1C86, 0x1C86, -6204, 1}, {0x1C87, 0x1C87, -6180, 1}, {0x1C88, 0x1C88, 35267, 1},
+    {0x1C90, 0x1CBA, -3008, 1}, {0x1CBD, 0x1CBF, -3008, 1}, {0x1E00, 0x1E94, 1, 2},
+    {0x1E9B, 0x1E9B, -58, 1}, {0x1E9E, 0x1E9E, -7615, 1}, {0x1EA0, 0x1EFE, 1, 2},
+    {0x1F08, 0x1F0F, -8, 1}, {0x1F18, 0x1F1D, -8, 1}, {0x1F28, 0x1F2F, -8, 1},
+    {0x1F38, 0x1F3F, -8, 1}, {0x1F48, 0x1F4D, -8, 1}, {0x1F59, 0x1F5F, -8, 2},
+    {0x1F68, 0x1F6F, -8, 1}, {0x1F88, 0x1F8F, -8, 1}, {0x1F98, 0x1F9F, -8, 1},
+    {0x1FA8, 0x1FAF, -8, 1}, {0x1FB8, 0x1FB9, -8, 1}, {0x1FBA, 0x1FBB, -74, 1},
+    {0x1FBC, 0x1FBC, -9, 1}, {0x1FBE, 0x1FBE, -7173, 1}, {0x1FC8, 0x1FCB, -86, 1},
+    {0x1FCC, 0x1FCC, -9, 1}, {0x1FD8, 0x1FD9, -8, 1}, {0x1FDA, 0x1FDB, -100, 1},
+    {0x1FE8, 0x1FE9, -8, 1}, {0x1FEA, 0x1FEB, -112, 1}, {0x1FEC, 0x1FEC, -7, 1},
+    {0x1FF8, 0x1FF9, -128, 1}, {0x1FFA, 0x1FFB, -126, 1}, {0x1FFC, 0x1FFC, -9, 1},
+    {0x2126, 0x2126, -7517, 1}, {0x212A, 0x212A, -8383, 1}, {0x212B, 0x212B, -8262, 1},
+    {0x2132, 0x2132, 28, 1}, {0x2160, 0x216F, 16, 1}, {0x2183, 0x2183, 1, 1},
+    {0x24B6, 0x24CF, 26, 1}, {0x2C00, 0x2C2F, 48, 1}, {0x2C60, 0x2C60, 1, 1},
+    {0x2C62, 0x2C62, -10743, 1}, {0x2C63, 0x2C63, -3814, 1}, {0x2C64, 0x2C64, -10727, 1},
+    {0x2C67, 0x2C6B, 1, 2}, {0x2C6D, 0x2C6D, -10780, 1}, {0x2C6E, 0x2C6E, -10749, 1},
+    {0x2C6F, 0x2C6F, -10783, 1}, {0x2C70, 0x2C70, -10782, 1}, {0x2C72, 0x2C72, 1, 1},
+    {0x2C75, 0x2C75, 1, 1}, {0x2C7E, 0x2C7F, -10815, 1}, {0x2C80, 0x2CE2, 1, 2},
+    {0x2CEB, 0x2CED, 1, 2}, {0x2CF2, 0x2CF2, 1, 1}, {0xA640, 0xA66C, 1, 2},
+    {0xA680, 0xA69A, 1, 2}, {0xA722, 0xA72E, 1, 2}, {0xA732, 0xA76E, 1, 2},
+    {0xA779, 0xA77B, 1, 2}, {0xA77D, 0xA77D, -35332, 1}, {0xA77E, 0xA786, 1, 2},
+    {0xA78B, 0xA78B, 1, 1}, {0xA78D, 0xA78D, -42280, 1}, {0xA790, 0xA792, 1, 2},
+    {0xA796, 0xA7A8, 1, 2}, {0xA7AA, 0xA7AA, -42308, 1}, {0xA7AB, 0xA7AB, -42319, 1},
+    {0xA7AC, 0xA7AC, -42315, 1}, {0xA7AD, 0xA7AD, -42305, 1}, {0xA7AE, 0xA7AE, -42308, 1},
+    {0xA7B0, 0xA7B0, -42258, 1}, {0xA7B1, 0xA7B1, -42282, 1}, {0xA7B2, 0xA7B2, -42261, 1},
+    {0xA7B3, 0xA7B3, 928, 1}, {0xA7B4, 0xA7C2, 1, 2}, {0xA7C4, 0xA7C4, -48, 1},
+    {0xA7C5, 0xA7C5, -42307, 1}, {0xA7C6, 0xA7C6, -35384, 1}, {0xA7C7, 0xA7C9, 1, 2},
+    {0xA7D0, 0xA7D0, 1, 1}, {0xA7D6, 0xA7D8, 1, 2}, {0xA7F5, 0xA7F5, 1, 1},
+    {0xAB70, 0xABBF, -38864, 1}, {0xFF21, 0xFF3A, 32, 1}, {0x10400, 0x10427, 40, 1},
+    {0x104B0, 0x104D3, 40, 1}, {0x10570, 0x1057A, 39, 1}, {0x1057C, 0x1058A, 39, 1},
+    {0x1058C, 0x10592, 39, 1}, {0x10594, 0x10595, 39, 1}, {0x10C80, 0x10CB2, 64, 1},
+    {0x118A0, 0x118BF, 32, 1}, {0x16E40, 0x16E5F, 32, 1}, {0x1E900, 0x1E921, 34, 1},
+};
+
+uint32_t foldCodepoint(uint32_t cp)
+{
+    int low = 0;
+    int high = (int)(sizeof(caseRanges) / sizeof(caseRanges[0])) - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        const CaseRange *range = &caseRanges[mid];
+        if (cp < range->first)
+        {
+            high = mid - 1;
+        }
+        else if (cp > range->last)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            return (cp - range->first) % range->stride ? cp : cp + range->delta;
+        }
+    }
+    return cp;
+}
+
+// Decode the UTF-8 character at s (at most avail bytes). Returns its length,
+// or 0 for a malformed, overlong or surrogate sequence.
+static size_t decodeUtf8(const unsigned char *s, size_t avail, uint32_t *cp)
+{
+    size_t length = s[0] >= 0xF0 ? 4 : s[0] >= 0xE0 ? 3 : s[0] >= 0xC0 ? 2 : 0;
+    if (length == 0 || length > avail || s[0] > 0xF4)
+    {
+        return 0;
+    }
+    uint32_t value = s[0] & (0x7F >> length);
+    for (size_t i = 1; i < length; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+        value = value << 6 | (s[i] & 0x3F);
+    }
+    static const uint32_t smallest[5] = {0, 0, 0x80, 0x800, 0x10000};
+    if (value < smallest[length] || value > 0x10FFFF || (value >= 0xD800 && value < 0xE000))
+    {
+        return 0;
+    }
+    *cp = value;
+    return length;
+}
+
+static size_t encodeUtf8(uint32_t cp, unsigned char *out)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (unsigned char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (unsigned char)(0xC0 | cp >> 6);
+        out[1] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (unsigned char)(0xE0 | cp >> 12);
+        out[1] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+        out[2] = (unsigned char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (unsigned char)(0xF0 | cp >> 18);
+    out[1] = (unsigned char)(0x80 | (cp >> 12 & 0x3F));
+    out[2] = (unsigned char)(0x80 | (cp >> 6 & 0x3F));
+    out[3] = (unsigned char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Case-fold the len bytes of text into out, which needs room for 2 * len + 1
+// bytes (folding grows a character by half at most), and NUL-terminate it.
+// ASCII runs are folded 16 bytes at a time; bytes that are not valid UTF-8
+// are copied unchanged. Sets *changed if the folded text differs from text.
+// Returns the folded length.
+size_t foldText(const char *text, size_t len, char *out, int *changed)
+{
+    const unsigned char *in = (const unsigned char *)text;
+    unsigned char *to = (unsigned char *)out;
+    size_t i = 0;
+    size_t o = 0;
+    int differs = 0;
+    while (i < len)
+    {
+#ifdef WORDLIST_X86_SIMD
+        // A short tail is padded into a block of its own, as reading past
+        // text could cross into an unmapped page
+        size_t run = len - i < 16 ? len - i : 16;
+        unsigned char tail[16] = {0};
+        const unsigned char *from = in + i;
+        if (run < 16)
+        {
+            memcpy(tail, from, run);
+            from = tail;
+        }
+        __m128i block = _mm_loadu_si128((const __m128i *)from);
+        if (!_mm_movemask_epi8(block))
+        {
+            __m128i folded = foldBlockSse2(block);
+            differs |= _mm_movemask_epi8(_mm_cmpeq_epi8(folded, block)) != 0xFFFF;
+            if (run < 16)
+            {
+                _mm_storeu_si128((__m128i *)tail, folded);
+                memcpy(to + o, tail, run);
+            }
+            else
+            {
+                _mm_storeu_si128((__m128i *)(to + o), folded);
+            }
+            i += run;
+            o += run;
+            continue;
+        }
+#endif
+        if (in[i] < 0x80)
+        {
+            to[o] = foldByte(in[i]);
+            differs |= to[o] != in[i];
+            i++;
+            o++;
+            continue;
+        }
+        uint32_t cp;
+        size_t length = decodeUtf8(in + i, len - i, &cp);
+        if (!length)
+        {
+            to[o++] = in[i++];
+            continue;
+        }
+        uint32_t folded = foldCodepoint(cp);
+        if (folded == cp)
+        {
+            memcpy(to + o, in + i, length);
+            o += length;
+        }
+        else
+        {
+            o += encodeUtf8(folded, to + o);
+            differs = 1;
+        }
+        i += length;
+    }
+    to[o] = 0;
+    if (changed)
+    {
+        *changed = differs;
+    }
+    return o;
+}
+
+// Fold a find's pattern into buffer (FOLD_BUFFER_SIZE bytes), or into a copy
+// the caller frees if it does not fit
+char *foldPattern(const char *pattern, char *buffer)
+{
+    size_t len = strlen(pattern);
+    char *out = 2 * len + 1 <= FOLD_BUFFER_SIZE ? buffer : (char *)malloc(2 * len + 1);
+    if (!out)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    foldText(pattern, len, out, NULL);
+    return out;
+}
+
+// A word's signature: a bit for each byte value its folded form contains
+// (letters and digits one of their own, anything else one of 20 shared
+// ones) and, in the top byte, one for each of the lengths 2, 3, 4, 6, 8,
+// 12, 16 and 24 it reaches. A word can only contain a pattern whose
+// signature bits it has all of.
+uint64_t wordSignature(const char *folded)
+{
+    static const size_t lengths[8] = {2, 3, 4, 6, 8, 12, 16, 24};
+    uint64_t signature = 0;
+    const unsigned char *c = (const unsigned char *)folded;
+    for (; *c; c++)
+    {
+        if (*c >= 'a' && *c <= 'z')
+        {
+            signature |= 1ull << (*c - 'a');
+        }
+        else if (*c >= '0' && *c <= '9')
+        {
+            signature |= 1ull << (26 + *c - '0');
+        }
+        else
+        {
+            signature |= 1ull << (36 + *c % 20);
+        }
+    }
+    size_t len = (size_t)(c - (const unsigned char *)folded);
+    for (int k = 0; k < 8 && len >= lengths[k]; k++)
+    {
+        signature |= 1ull << (56 + k);
+    }
+    return signature;
+}
+
+// Bit k is set for word from + k (k < n <= 64) if its signature has all of
+// the current find's. The signatures are tested a segment (or the ring's
+// end) at a time; interned and compressed lists have every bit set, as
+// their words are filtered by the memo and by block.
+uint64_t candidateBits(const WordList *list, int from, int n)
+{
+    if (!list->need || list->ids || list->packed.blocks)
+    {
+        return n == 64 ? ~0ull : (1ull << n) - 1;
+    }
+    uint64_t (*kernel)(const uint64_t *, int, uint64_t) = __atomic_load_n(&signatureKernel, __ATOMIC_RELAXED);
+    uint64_t bits = 0;
+    for (int k = 0; k < n;)
+    {
+        uint32_t slot = (uint32_t)((from + k) & list->mask);
+        int segment = segmentOf(slot);
+        uint32_t offset = slot - segmentStart(segment);
+        uint32_t run = segmentStart(segment + 1) - segmentStart(segment) - offset;
+        if (list->window && run > (uint32_t)list->mask + 1 - slot)
+        {
+            run = (uint32_t)list->mask + 1 - slot;
+        }
+        if (run > (uint32_t)(n - k))
+        {
+            run = (uint32_t)(n - k);
+        }
+        bits |= kernel(list->signatures[segment] + offset, (int)run, list->need) << k;
+        k += (int)run;
+    }
+    return bits;
+}
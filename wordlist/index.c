@@ -0,0 +1,162 @@
+// The trigram substring index.
+
+#include "wordlist.h"
+
+// Hash a case-folded trigram into one of the index buckets
+unsigned trigramBucket(const char *str)
+{
+    unsigned key = (unsigned)tolower((unsigned char)str[0]) << 16 |
+                   (unsigned)tolower((unsigned char)str[1]) << 8 |
+                   (unsigned)tolower((unsigned char)str[2]);
+    return (key * 2654435761u) >> 16 & (TRIGRAM_BUCKETS - 1);
+}
+
+// Keep a posting array that server readers may still be scanning until the
+// server stops
+static void retirePosting(Server *server, int *ids)
+{
+    if (server->retiredSize >= server->retiredCapacity)
+    {
+        server->retiredCapacity = server->retiredCapacity ? server->retiredCapacity * 2 : 64;
+        server->retired = (int **)realloc(server->retired, server->retiredCapacity * sizeof(int *));
+        if (!server->retired)
+        {
+            fprintf(stderr, "Memory reallocation failed\n");
+            exit(1);
+        }
+    }
+    server->retired[server->retiredSize++] = ids;
+}
+
+// Add word `id` to the posting list of every trigram it contains in the
+// index trigrams. Ids are appended in insertion order, so each posting list
+// stays sorted. A list being served publishes each posting list's ids and
+// size atomically, and grows the ids into a new array rather than moving
+// them, since readers may hold the old one.
+void indexWord(WordList *list, PostingList *trigrams, int id)
+{
+    int shared = list->server && trigrams == list->trigrams;
+    const char *word = foldAt(list, id);
+    for (size_t i = 0; word[i] && word[i + 1] && word[i + 2]; i++)
+    {
+        PostingList *posting = &trigrams[trigramBucket(word + i)];
+        if (posting->size > 0 && posting->ids[posting->size - 1] == id)
+        {
+            continue;
+        }
+        if (posting->size >= posting->capacity)
+        {
+            posting->capacity = posting->capacity ? posting->capacity * 2 : 4;
+            if (shared && posting->ids)
+            {
+                int *ids = (int *)malloc(posting->capacity * sizeof(int));
+                if (!ids)
+                {
+                    fprintf(stderr, "Memory allocation failed\n");
+                    exit(1);
+                }
+                memcpy(ids, posting->ids, posting->size * sizeof(int));
+                retirePosting(list->server, posting->ids);
+                __atomic_store_n(&posting->ids, ids, __ATOMIC_RELEASE);
+            }
+            else
+            {
+                int *ids = (int *)realloc(posting->ids, posting->capacity * sizeof(int));
+                if (!ids)
+                {
+                    fprintf(stderr, "Memory reallocation failed\n");
+                    exit(1);
+                }
+                __atomic_store_n(&posting->ids, ids, __ATOMIC_RELEASE);
+            }
+        }
+        posting->ids[posting->size] = id;
+        __atomic_store_n(&posting->size, posting->size + 1, __ATOMIC_RELEASE);
+    }
+}
+
+// Index the list's words, then publish the index for server readers
+void buildIndex(WordList *list)
+{
+    PostingList *trigrams = (PostingList *)calloc(TRIGRAM_BUCKETS, sizeof(PostingList));
+    if (!trigrams)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < list->size; i++)
+    {
+        indexWord(list, trigrams, i);
+    }
+    __atomic_store_n(&list->trigrams, trigrams, __ATOMIC_RELEASE);
+}
+
+void freeIndex(WordList *list)
+{
+    if (!list->trigrams)
+    {
+        return;
+    }
+    for (int i = 0; i < TRIGRAM_BUCKETS; i++)
+    {
+        free(list->trigrams[i].ids);
+    }
+    free(list->trigrams);
+    list->trigrams = NULL;
+}
+
+// Every word containing the pattern appears in the posting list of each of the
+// pattern's trigrams, so the shortest of those lists is a complete candidate
+// set. Returns NULL when the index cannot narrow the search.
+const PostingList *indexCandidates(const WordList *list, const char *pattern)
+{
+    if (!list->trigrams)
+    {
+        return NULL;
+    }
+    const PostingList *best = NULL;
+    int bestSize = 0;
+    for (size_t i = 0; pattern[i] && pattern[i + 1] && pattern[i + 2]; i++)
+    {
+        // Sizes only hint which list is shortest; the scan reads its own
+        const PostingList *posting = &list->trigrams[trigramBucket(pattern + i)];
+        int size = __atomic_load_n(&posting->size, __ATOMIC_RELAXED);
+        if (!best || size < bestSize)
+        {
+            best = posting;
+            bestSize = size;
+        }
+    }
+    return best;
+}
+
+void setIndex(WordList *list, const char *mode)
+{
+    if (strcmp(mode, "on") == 0)
+    {
+        if (list->window)
+        {
+            replyError("Error: The substring index is not available in streaming mode\n");
+            return;
+        }
+        if (!list->trigrams)
+        {
+            buildIndex(list);
+        }
+        reply("Substring index enabled (%d words indexed).\n", list->size);
+    }
+    else if (strcmp(mode, "off") == 0)
+    {
+        if (list->server)
+        {
+            replyError("Error: The substring index cannot be turned off while serving\n");
+            return;
+        }
+        freeIndex(list);
+        reply("Substring index disabled.\n");
+    }
+    else
+    {
+        replyError("Error: Invalid index mode '%s' (expected on/off)\n", mode);
+    }
+}
@@ -0,0 +1,144 @@
+// Interning: each distinct word kept once.
+
+#include "wordlist.h"
+
+uint32_t hashWord(const char *word)
+{
+    uint32_t hash = 2166136261u;
+    for (; *word; word++)
+    {
+        hash = (hash ^ (unsigned char)*word) * 16777619u;
+    }
+    return hash;
+}
+
+static void growIntern(InternTable *intern, WordList *list)
+{
+    intern->capacity = intern->capacity ? intern->capacity * 2 : INITIAL_CAPACITY;
+    reserveSlots(list, (uint32_t)intern->capacity);
+    intern->counts = (int *)realloc(intern->counts, intern->capacity * sizeof(int));
+    intern->memo = (uint32_t *)realloc(intern->memo, intern->capacity * sizeof(uint32_t));
+    if (!intern->counts || !intern->memo)
+    {
+        fprintf(stderr, "Memory reallocation failed\n");
+        exit(1);
+    }
+    // Keep the table at most half full. The hashes kept in the slots place
+    // the words again without rehashing them.
+    int slots = 2 * (intern->slotMask + 1);
+    while (slots < 2 * intern->capacity) slots *= 2;
+    uint64_t *old = intern->slots;
+    int oldSlots = intern->slotMask + 1;
+    intern->slots = (uint64_t *)calloc(slots, sizeof(uint64_t));
+    if (!intern->slots)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    intern->slotMask = slots - 1;
+    for (int i = 0; old && i < oldSlots; i++)
+    {
+        if (old[i])
+        {
+            uint32_t at = (uint32_t)(old[i] >> 32) & intern->slotMask;
+            while (intern->slots[at]) at = (at + 1) & intern->slotMask;
+            intern->slots[at] = old[i];
+        }
+    }
+    free(old);
+}
+
+// Return the distinct id of word, adding it (copied into the arena if copy
+// is set) the first time it is seen, and count the occurrence
+uint32_t internWord(WordList *list, char *word, int copy)
+{
+    InternTable *intern = &list->intern;
+    uint32_t hash = hashWord(word);
+    uint32_t at = hash & intern->slotMask;
+    for (; intern->slots[at]; at = (at + 1) & intern->slotMask)
+    {
+        uint32_t distinct = (uint32_t)intern->slots[at] - 1;
+        if (intern->slots[at] >> 32 == hash && strcmp(*wordSlot(list, distinct), word) == 0)
+        {
+            intern->counts[distinct]++;
+            return distinct;
+        }
+    }
+    if (intern->size >= intern->capacity)
+    {
+        growIntern(intern, list);
+        at = hash & intern->slotMask;
+        while (intern->slots[at]) at = (at + 1) & intern->slotMask;
+    }
+    uint32_t distinct = (uint32_t)intern->size++;
+    storeWord(list, distinct, word, copy);
+    intern->counts[distinct] = 1;
+    intern->memo[distinct] = 0;
+    intern->slots[at] = (uint64_t)hash << 32 | (distinct + 1);
+    return distinct;
+}
+
+void freeIntern(WordList *list)
+{
+    InternTable *intern = &list->intern;
+    free(intern->slots);
+    free(intern->counts);
+    free(intern->memo);
+    free(list->ids);
+    list->ids = NULL;
+    memset(intern, 0, sizeof(*intern));
+}
+
+// Switch an empty list to storing each distinct word once, or back
+// Start interning the (empty) list's words
+void enableIntern(WordList *list)
+{
+    list->ids = (uint32_t *)malloc(list->capacity * sizeof(uint32_t));
+    list->intern.slots = (uint64_t *)calloc(1, sizeof(uint64_t));
+    if (!list->ids || !list->intern.slots)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    // words and keys hold the distinct words from now on
+    growIntern(&list->intern, list);
+}
+
+void setIntern(WordList *list, const char *mode)
+{
+    int on = strcmp(mode, "on") == 0;
+    if (!on && strcmp(mode, "off") != 0)
+    {
+        replyError("Error: Invalid intern mode '%s' (expected on/off)\n", mode);
+        return;
+    }
+    if (list->server)
+    {
+        replyError("Error: Interning cannot be changed while serving\n");
+        return;
+    }
+    if (list->size > 0)
+    {
+        replyError("Error: Interning has to be set before any words are added\n");
+        return;
+    }
+    if (on && list->window)
+    {
+        replyError("Error: Interning cannot be used in streaming mode\n");
+        return;
+    }
+    if (on && list->packed.blocks)
+    {
+        replyError("Error: Interning cannot be used with compression\n");
+        return;
+    }
+    if (on && !list->ids)
+    {
+        enableIntern(list);
+    }
+    else if (!on && list->ids)
+    {
+        freeIntern(list);
+    }
+    reply(on ? "Interning enabled.\n" : "Interning disabled.\n");
+}
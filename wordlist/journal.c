@@ -0,0 +1,425 @@
+// The journal: a log of appended words on top of a snapshot.
+
+#include "wordlist.h"
+
+uint32_t recordChecksum(const char *word, uint32_t length)
+{
+    Checksum sum;
+    checksumInit(&sum);
+    checksumUpdate(&sum, &length, sizeof(length));
+    checksumUpdate(&sum, word, length);
+    return (uint32_t)checksumFinish(&sum);
+}
+
+// Queue one record for a word just appended to the list
+void journalAppend(WordList *list, const char *word)
+{
+    Journal *journal = &list->journal;
+    if (journal->fd < 0)
+    {
+        return;
+    }
+    uint32_t length = (uint32_t)strlen(word);
+    uint32_t check = recordChecksum(word, length);
+    size_t record = 2 * sizeof(uint32_t) + length;
+    if (journal->used + record > JOURNAL_BUFFER_SIZE)
+    {
+        if (!journalWrite(list, journal->buffer, journal->used))
+        {
+            return;
+        }
+        journal->used = 0;
+    }
+    if (record > JOURNAL_BUFFER_SIZE)
+    {
+        // Too big to queue: write it straight through
+        uint32_t head[2] = {length, check};
+        if (journalWrite(list, (const char *)head, sizeof(head)))
+        {
+            journalWrite(list, word, length);
+        }
+        return;
+    }
+    memcpy(journal->buffer + journal->used, &length, sizeof(length));
+    memcpy(journal->buffer + journal->used + sizeof(length), &check, sizeof(check));
+    memcpy(journal->buffer + journal->used + 2 * sizeof(uint32_t), word, length);
+    journal->used += record;
+}
+
+// Write to the log, turning journaling off if that fails
+int journalWrite(WordList *list, const char *data, size_t length)
+{
+    Journal *journal = &list->journal;
+    while (length > 0)
+    {
+        ssize_t wrote = write(journal->fd, data, length);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0)
+        {
+            replyError("Error: Cannot write journal '%s.log'; journaling stopped.\n", journal->path);
+            journal->used = 0;
+            closeJournal(list);
+            return 0;
+        }
+        list->stats.bytesWritten += (size_t)wrote;
+        data += wrote;
+        length -= (size_t)wrote;
+    }
+    return 1;
+}
+
+// Commit point: write out the queued records as one group and sync them if
+// the policy asks for it. Called after every interactive command, after
+// each block of batch commands and before the journal is compacted or closed.
+void journalCommit(WordList *list)
+{
+    Journal *journal = &list->journal;
+    if (journal->fd < 0)
+    {
+        return;
+    }
+    if (journal->used > 0)
+    {
+        if (!journalWrite(list, journal->buffer, journal->used))
+        {
+            return;
+        }
+        journal->used = 0;
+        if (journal->policy == SYNC_ALWAYS ||
+            (journal->policy == SYNC_PERIODIC && elapsedMs(&journal->lastSync) >= JOURNAL_SYNC_MS))
+        {
+            fdatasync(journal->fd);
+            clock_gettime(CLOCK_MONOTONIC, &journal->lastSync);
+        }
+    }
+}
+
+// Append the words of the log at logPath that the snapshot does not already
+// hold. A torn or corrupt record ends the log: it and everything after it
+// are cut off so new records follow the last good one. Returns the number
+// of words replayed, or -1 if the log cannot be used.
+int journalReplay(WordList *list, const char *logPath)
+{
+    int fd = open(logPath, O_RDWR);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    size_t length = (size_t)st.st_size;
+    char *data = length >= sizeof(JournalHeader)
+                     ? (char *)mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0)
+                     : (char *)MAP_FAILED;
+    const JournalHeader *header = (const JournalHeader *)data;
+    if (data == MAP_FAILED || memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0 ||
+        header->base > (uint64_t)list->size)
+    {
+        if (data != MAP_FAILED) munmap(data, length);
+        close(fd);
+        return -1;
+    }
+    list->stats.bytesRead += length;
+    // Records up to the snapshot's size were folded into it by a compaction
+    // that stopped before the log was reset
+    uint64_t skip = (uint64_t)list->size - header->base;
+    int replayed = 0;
+    size_t at = sizeof(JournalHeader);
+    while (length - at >= 2 * sizeof(uint32_t))
+    {
+        uint32_t head[2];
+        memcpy(head, data + at, sizeof(head));
+        const char *word = data + at + sizeof(head);
+        if (head[0] > length - at - sizeof(head) || recordChecksum(word, head[0]) != head[1] ||
+            memchr(word, 0, head[0]) != NULL)
+        {
+            break;
+        }
+        at += sizeof(head) + head[0];
+        if (skip > 0)
+        {
+            skip--;
+            continue;
+        }
+        char copy[MAX_WORD_LEN];
+        char *text = head[0] < sizeof(copy) ? copy : arenaAlloc(list, head[0] + 1);
+        memcpy(text, word, head[0]);
+        text[head[0]] = 0;
+        appendWord(list, text, text == copy);
+        replayed++;
+    }
+    munmap(data, length);
+    if (at < length)
+    {
+        reply("Journal '%s' ends in a damaged record; %zu bytes dropped.\n", logPath, length - at);
+        if (ftruncate(fd, (off_t)at) != 0 || fsync(fd) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    close(fd);
+    return replayed;
+}
+
+// Start a new, empty log based on the current list size and switch the
+// journal to it. The new log is written beside the old one and renamed over
+// it, so a crash leaves one or the other.
+int journalReset(WordList *list)
+{
+    Journal *journal = &list->journal;
+    size_t pathLength = strlen(journal->path);
+    char *logPath = (char *)malloc(pathLength + 9);
+    if (!logPath)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    sprintf(logPath, "%s.log", journal->path);
+    sprintf(logPath + pathLength + 4, ".tmp");
+    int fd = open(logPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    JournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.base = (uint64_t)list->size;
+    int ok = fd >= 0 && write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) && fsync(fd) == 0;
+    char *tmpPath = strdup(logPath);
+    logPath[pathLength + 4] = 0;
+    ok = ok && tmpPath && rename(tmpPath, logPath) == 0 && syncDirectory(logPath);
+    free(tmpPath);
+    free(logPath);
+    if (!ok)
+    {
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    if (journal->fd >= 0)
+    {
+        close(journal->fd);
+    }
+    // The renamed file is still open: keep appending to it
+    journal->fd = fd;
+    lseek(fd, 0, SEEK_END);
+    return 1;
+}
+
+// Drop the words a failed open replayed, leaving the list empty again with
+// the same settings, so that a journal can still be opened later
+static void discardReplay(WordList *list)
+{
+    int threads = list->threads;
+    int quiet = list->quiet;
+    int indexed = list->trigrams != NULL;
+    int cached = list->cache.entries != NULL;
+    int interned = list->ids != NULL;
+    int packed = list->packed.blocks != NULL;
+    Stats stats = list->stats;
+    freeWordList(list);
+    initWordList(list);
+    list->threads = threads;
+    list->quiet = quiet;
+    list->stats = stats;
+    if (!cached)
+    {
+        freeCache(list);
+    }
+    if (interned)
+    {
+        enableIntern(list);
+    }
+    if (packed)
+    {
+        enablePacked(list);
+    }
+    if (indexed)
+    {
+        buildIndex(list);
+    }
+}
+
+// Replay the snapshot at path and then its log (path.log), and log every
+// word appended from now on. The list has to be empty, so that it always
+// equals the snapshot followed by the log.
+void openJournal(WordList *list, const char *path, SyncPolicy policy)
+{
+    Journal *journal = &list->journal;
+    if (journal->fd >= 0)
+    {
+        replyError("Error: Journal '%s' is already open\n", journal->path);
+        return;
+    }
+    if (list->window)
+    {
+        replyError("Error: Streaming mode cannot be used with the substring index or a journal\n");
+        return;
+    }
+    if (list->size > 0)
+    {
+        replyError("Error: The journal has to be opened before any words are added\n");
+        return;
+    }
+    if (list->server)
+    {
+        replyError("Error: A journal cannot be opened while serving\n");
+        return;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (access(path, F_OK) == 0 && !loadSnapshot(list, path))
+    {
+        return;
+    }
+    size_t pathLength = strlen(path);
+    char *logPath = (char *)malloc(pathLength + 5);
+    journal->path = strdup(path);
+    journal->buffer = (char *)malloc(JOURNAL_BUFFER_SIZE);
+    if (!logPath || !journal->path || !journal->buffer)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    sprintf(logPath, "%s.log", path);
+    int replayed = 0;
+    if (access(logPath, F_OK) == 0)
+    {
+        replayed = journalReplay(list, logPath);
+        if (replayed < 0)
+        {
+            replyError("Error: '%s' is not a usable journal for '%s'.\n", logPath, path);
+            free(logPath);
+            discardReplay(list);
+            return;
+        }
+        journal->fd = open(logPath, O_WRONLY | O_APPEND);
+    }
+    else if (!journalReset(list))
+    {
+        journal->fd = -1;
+    }
+    if (journal->fd < 0)
+    {
+        replyError("Cannot open file '%s'.\n", logPath);
+        free(logPath);
+        discardReplay(list);
+        return;
+    }
+    free(logPath);
+    journal->policy = policy;
+    journal->used = 0;
+    clock_gettime(CLOCK_MONOTONIC, &journal->lastSync);
+    reply("Journal '%s' open: %d words replayed from its log in %.1f ms, %d words in total.\n",
+          path, replayed, elapsedMs(&start), list->size);
+}
+
+// Commit what is queued, sync it and stop journaling
+void closeJournal(WordList *list)
+{
+    Journal *journal = &list->journal;
+    if (journal->fd >= 0)
+    {
+        int fd = journal->fd;
+        if (journal->used > 0)
+        {
+            journalWrite(list, journal->buffer, journal->used);
+        }
+        if (journal->fd >= 0)
+        {
+            fsync(fd);
+            close(fd);
+        }
+    }
+    journal->fd = -1;
+    journal->used = 0;
+    free(journal->path);
+    free(journal->buffer);
+    journal->path = NULL;
+    journal->buffer = NULL;
+}
+
+void journal(WordList *list, const char *arg)
+{
+    if (strcmp(arg, "off") == 0)
+    {
+        if (list->journal.fd >= 0)
+        {
+            closeJournal(list);
+            reply("Journal closed.\n");
+        }
+        else
+        {
+            replyError("Error: No journal is open\n");
+        }
+        return;
+    }
+    // <path> [always|periodic|none]
+    char path[1024];
+    char mode[16] = "periodic";
+    int end = 0;
+    int fields = sscanf(arg, "%1023s %n%15s %n", path, &end, mode, &end);
+    if (fields < 1 || arg[end] != '\0')
+    {
+        replyError("Error: Invalid journal arguments\n");
+        return;
+    }
+    SyncPolicy policy;
+    if (strcmp(mode, "always") == 0)
+    {
+        policy = SYNC_ALWAYS;
+    }
+    else if (strcmp(mode, "periodic") == 0)
+    {
+        policy = SYNC_PERIODIC;
+    }
+    else if (strcmp(mode, "none") == 0)
+    {
+        policy = SYNC_NONE;
+    }
+    else
+    {
+        replyError("Error: Invalid sync policy '%s' (expected always/periodic/none)\n", mode);
+        return;
+    }
+    openJournal(list, path, policy);
+}
+
+// Fold the log into a fresh snapshot and start an empty log. The snapshot is
+// written beside the old one, synced and renamed over it before the log is
+// reset; a crash in between is handled by the log's base count on replay.
+void compact(WordList *list, const char *arg)
+{
+    (void)arg;
+    Journal *journal = &list->journal;
+    if (journal->fd < 0)
+    {
+        replyError("Error: No journal is open\n");
+        return;
+    }
+    journalCommit(list);
+    if (journal->fd < 0)
+    {
+        return;
+    }
+    char *tmpPath = (char *)malloc(strlen(journal->path) + 5);
+    if (!tmpPath)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    sprintf(tmpPath, "%s.tmp", journal->path);
+    int ok = writeSnapshot(list, tmpPath, 1);
+    if (ok && (rename(tmpPath, journal->path) != 0 || !syncDirectory(journal->path)))
+    {
+        replyError("Error: Cannot replace snapshot '%s'.\n", journal->path);
+        ok = 0;
+    }
+    free(tmpPath);
+    if (ok && !journalReset(list))
+    {
+        replyError("Error: Cannot reset journal '%s.log'.\n", journal->path);
+        ok = 0;
+    }
+    if (ok)
+    {
+        reply("Compacted %d words into '%s'.\n", list->size, journal->path);
+    }
+}
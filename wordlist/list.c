@@ -0,0 +1,467 @@
+// The word list: slots in segments, the arena holding word text, adding
+// words and the settings that shape the list (threads, streaming window).
+
+#include "wordlist.h"
+
+// The length of the white space character at s: an ASCII one, or one of
+// the UTF-8 encoded spaces (U+0085, U+00A0, U+1680, U+2000-U+200A, U+2028,
+// U+2029, U+202F, U+205F and U+3000). 0 if s starts with anything else.
+static size_t spaceLength(const unsigned char *s)
+{
+    if (isspace(s[0]))
+    {
+        return 1;
+    }
+    if (s[0] == 0xC2 && (s[1] == 0x85 || s[1] == 0xA0))
+    {
+        return 2;
+    }
+    if ((s[0] == 0xE1 && s[1] == 0x9A && s[2] == 0x80) ||
+        (s[0] == 0xE2 && s[1] == 0x80 && ((s[2] >= 0x80 && s[2] <= 0x8A) || s[2] == 0xA8 || s[2] == 0xA9 || s[2] == 0xAF)) ||
+        (s[0] == 0xE2 && s[1] == 0x81 && s[2] == 0x9F) ||
+        (s[0] == 0xE3 && s[1] == 0x80 && s[2] == 0x80))
+    {
+        return 3;
+    }
+    return 0;
+}
+
+char *trim(char *str)
+{
+    size_t skip;
+    while ((skip = spaceLength((const unsigned char *)str)) > 0) str += skip;
+    if (*str == 0) return str;
+    char *end = str + strlen(str);
+    while (end > str)
+    {
+        // A space ending the word is 1 to 3 bytes long
+        size_t length = 0;
+        for (size_t k = 1; k <= 3 && end - k >= str && !length; k++)
+        {
+            if (spaceLength((const unsigned char *)end - k) == k)
+            {
+                length = k;
+            }
+        }
+        if (!length)
+        {
+            break;
+        }
+        end -= length;
+    }
+    *end = 0;
+    return str;
+}
+
+void initWordList(WordList *list)
+{
+    list->capacity = INITIAL_CAPACITY;
+    list->size = 0;
+    list->base = 0;
+    list->window = 0;
+    list->mask = -1;
+    list->ids = NULL;
+    memset(&list->intern, 0, sizeof(list->intern));
+    memset(&list->packed, 0, sizeof(list->packed));
+    list->need = 0;
+    list->server = NULL;
+    list->chunks = NULL;
+    list->mappings = NULL;
+    list->trigrams = NULL;
+    list->threads = 1;
+    list->quiet = 0;
+    list->order.root = NULL;
+    list->order.nodes = NULL;
+    list->order.window = 0;
+    list->order.upto = 0;
+    list->order.seed = 2463534242u;
+    list->cache.entries = NULL;
+    list->cache.clock = 0;
+    enableCache(list);
+    list->matchers.entries = NULL;
+    list->matchers.clock = 0;
+    list->journal.fd = -1;
+    list->journal.path = NULL;
+    list->journal.buffer = NULL;
+    list->journal.used = 0;
+    memset(&list->stats, 0, sizeof(list->stats));
+    list->segments = 0;
+}
+
+// Make room for slots [0, slots) by adding segments. A segment is never
+// moved, so growing costs one allocation and no copy, and a reader holding
+// a slot's address keeps a valid one.
+void reserveSlots(WordList *list, uint32_t slots)
+{
+    while (segmentStart(list->segments) < slots)
+    {
+        int segment = list->segments;
+        uint32_t length = segmentStart(segment + 1) - segmentStart(segment);
+        list->words[segment] = (char **)malloc(length * sizeof(char *));
+        list->folds[segment] = (char **)malloc(length * sizeof(char *));
+        list->keys[segment] = (uint64_t *)malloc(length * sizeof(uint64_t));
+        list->signatures[segment] = (uint64_t *)malloc(length * sizeof(uint64_t));
+        if (!list->words[segment] || !list->folds[segment] || !list->keys[segment] || !list->signatures[segment])
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        list->segments++;
+    }
+}
+
+void resizeWordList(WordList *list)
+{
+    if (list->ids && list->size >= list->capacity)
+    {
+        list->capacity *= 2;
+        list->ids = (uint32_t *)realloc(list->ids, list->capacity * sizeof(uint32_t));
+        if (!list->ids)
+        {
+            fprintf(stderr, "Memory reallocation failed\n");
+            exit(1);
+        }
+    }
+    else if (!list->ids && !list->window && !list->packed.blocks)
+    {
+        reserveSlots(list, (uint32_t)list->size + 1);
+    }
+}
+
+void freeWordList(WordList *list)
+{
+    closeJournal(list);
+    freeIndex(list);
+    freeCache(list);
+    freeMatchers(list);
+    freeIntern(list);
+    freePacked(list);
+    free(list->order.nodes);
+    list->order.nodes = NULL;
+    list->order.root = NULL;
+    list->order.window = 0;
+    while (list->chunks)
+    {
+        ArenaChunk *next = list->chunks->next;
+        free(list->chunks);
+        list->chunks = next;
+    }
+    while (list->mappings)
+    {
+        Mapping *next = list->mappings->next;
+        munmap(list->mappings->addr, list->mappings->length);
+        free(list->mappings);
+        list->mappings = next;
+    }
+    for (int i = 0; i < list->segments; i++)
+    {
+        free(list->words[i]);
+        free(list->folds[i]);
+        free(list->keys[i]);
+        free(list->signatures[i]);
+    }
+    list->segments = 0;
+    list->size = 0;
+    list->base = 0;
+    list->capacity = 0;
+}
+
+// Reserve len bytes in the list's arena. Words are packed back to back into
+// large chunks, so the whole list is released with a handful of frees.
+char *arenaAlloc(WordList *list, size_t len)
+{
+    ArenaChunk *chunk = list->chunks;
+    if (!chunk || chunk->capacity - chunk->used < len)
+    {
+        size_t capacity = len > ARENA_CHUNK_SIZE ? len : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + capacity);
+        if (!chunk)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        // An oversized word gets a chunk of its own; keep filling the current one
+        if (capacity > ARENA_CHUNK_SIZE && list->chunks)
+        {
+            chunk->lastId = list->size + 1;
+            chunk->next = list->chunks->next;
+            list->chunks->next = chunk;
+        }
+        else
+        {
+            if (list->chunks)
+            {
+                list->chunks->lastId = list->size;
+            }
+            chunk->lastId = INT32_MAX;
+            chunk->next = list->chunks;
+            list->chunks = chunk;
+        }
+        releaseChunks(list);
+    }
+    char *block = (char *)(chunk + 1) + chunk->used;
+    chunk->used += len;
+    return block;
+}
+
+char *arenaStrdup(WordList *list, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *copy = arenaAlloc(list, len);
+    memcpy(copy, str, len);
+    return copy;
+}
+
+// In streaming mode, free the arena chunks whose words have all had their
+// ring slots reused. The chunk being filled is kept.
+void releaseChunks(WordList *list)
+{
+    if (!list->window || !list->chunks)
+    {
+        return;
+    }
+    int oldest = list->size - (list->mask + 1);
+    ArenaChunk **link = &list->chunks->next;
+    while (*link)
+    {
+        ArenaChunk *chunk = *link;
+        if (chunk->lastId <= oldest)
+        {
+            *link = chunk->next;
+            free(chunk);
+        }
+        else
+        {
+            link = &chunk->next;
+        }
+    }
+}
+
+// Fill slot with word, its folded form, sort key and signature. With copy set the
+// word is copied into the arena, and its folded form (if it differs) right
+// behind it, so the two live in the same chunk.
+void storeWord(WordList *list, uint32_t slot, char *word, int copy)
+{
+    size_t len = strlen(word);
+    char buffer[FOLD_BUFFER_SIZE];
+    char *folded = 2 * len + 1 <= sizeof(buffer) ? buffer : (char *)malloc(2 * len + 1);
+    if (!folded)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    int changed;
+    size_t foldedLen = foldText(word, len, folded, &changed);
+    char *stored = word;
+    char *fold = word;
+    if (copy)
+    {
+        stored = arenaAlloc(list, len + 1 + (changed ? foldedLen + 1 : 0));
+        memcpy(stored, word, len + 1);
+        fold = stored;
+        if (changed)
+        {
+            fold = stored + len + 1;
+            memcpy(fold, folded, foldedLen + 1);
+        }
+    }
+    else if (changed)
+    {
+        fold = arenaAlloc(list, foldedLen + 1);
+        memcpy(fold, folded, foldedLen + 1);
+    }
+    if (folded != buffer)
+    {
+        free(folded);
+    }
+    *wordSlot(list, slot) = stored;
+    *foldSlot(list, slot) = fold;
+    *keySlot(list, slot) = sortKey(fold);
+    *signatureSlot(list, slot) = wordSignature(fold);
+}
+
+int isAlphanumeric(const char *str)
+{
+    for (int i = 0; str[i]; i++)
+    {
+        if (!isalnum((unsigned char)str[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Store a word at the end of the list and keep the index current. The word
+// is copied into the arena first if copy is set, unless it is interned
+// already; a compressed list always copies it into its last block.
+void appendWord(WordList *list, char *word, int copy)
+{
+    resizeWordList(list);
+    if (list->packed.blocks)
+    {
+        packWord(list, word);
+    }
+    else if (list->ids)
+    {
+        list->ids[list->size] = internWord(list, word, copy);
+    }
+    else
+    {
+        uint32_t slot = (uint32_t)(list->size & list->mask);
+        storeWord(list, slot, word, copy);
+        word = *wordSlot(list, slot);
+    }
+    if (list->trigrams)
+    {
+        indexWord(list, list->trigrams, list->size);
+    }
+    // Server readers see the word once the size that covers it is published
+    __atomic_store_n(&list->size, list->size + 1, __ATOMIC_RELEASE);
+    if (list->window && list->size - list->base > list->window)
+    {
+        list->base++;
+        if (list->size >= WINDOW_REBASE_AT)
+        {
+            rebaseWindow(list);
+        }
+    }
+    journalAppend(list, word);
+}
+
+// Check that a trimmed word can be stored, printing why not if report is set
+int validateWord(const char *word, int report)
+{
+    if (strlen(word) == 0)
+    {
+        if (report) replyError("Error: Cannot insert empty word\n");
+        return 0;
+    }
+    if (isAlphanumeric(word))
+    {
+        if (report) replyError("Error: Cannot insert purely alphanumeric word: %s\n", word);
+        return 0;
+    }
+    return 1;
+}
+
+// Validate and store a trimmed word, copying it into the arena unless it
+// already lives in memory the list owns. Returns 1 if the word was stored.
+int addWord(WordList *list, char *word, int copy, int report)
+{
+    if (!validateWord(word, report))
+    {
+        return 0;
+    }
+    appendWord(list, word, copy);
+    if (!list->quiet)
+    {
+        reply("Inserted: %s\n", word);
+    }
+    return 1;
+}
+
+void insert(WordList *list, const char *word)
+{
+    addWord(list, trim((char *)word), 1, 1);
+}
+
+void setThreads(WordList *list, const char *arg)
+{
+    char *end;
+    long threads = strtol(arg, &end, 10);
+    if (*end != 0 || threads < 1 || threads > MAX_THREADS)
+    {
+        replyError("Error: Invalid thread count '%s' (expected 1-%d)\n", arg, MAX_THREADS);
+        return;
+    }
+    __atomic_store_n(&list->threads, (int)threads, __ATOMIC_RELAXED);
+    reply("Threads set to %d.\n", list->threads);
+}
+
+// Switch to streaming mode, keeping only the most recent words in a ring of
+// fixed size, or back to keeping every word. Only allowed while the list is
+// empty. Memory then stays bounded however many words arrive, apart from
+// snapshots added with loadbin, whose mappings live as long as the list.
+void setWindow(WordList *list, const char *arg)
+{
+    long window = 0;
+    if (strcmp(arg, "off") != 0)
+    {
+        char *end;
+        window = strtol(arg, &end, 10);
+        if (*end != 0 || window < 1 || window > MAX_WINDOW)
+        {
+            replyError("Error: Invalid window size '%s' (expected 1-%d or off)\n", arg, MAX_WINDOW);
+            return;
+        }
+    }
+    if (list->server)
+    {
+        replyError("Error: The window cannot be changed while serving\n");
+        return;
+    }
+    if (list->size > 0)
+    {
+        replyError("Error: The window has to be set before any words are added\n");
+        return;
+    }
+    if (window && (list->trigrams || list->journal.fd >= 0))
+    {
+        replyError("Error: Streaming mode cannot be used with the substring index or a journal\n");
+        return;
+    }
+    if (window && list->ids)
+    {
+        replyError("Error: Interning cannot be used in streaming mode\n");
+        return;
+    }
+    if (window && list->packed.blocks)
+    {
+        replyError("Error: Compression cannot be used in streaming mode\n");
+        return;
+    }
+    int slots = 1;
+    if (window)
+    {
+        while (slots < 2 * window) slots <<= 1;
+        reserveSlots(list, (uint32_t)slots);
+    }
+    list->window = (int)window;
+    list->mask = window ? slots - 1 : -1;
+    if (window)
+    {
+        reply("Streaming mode: keeping the last %d words.\n", list->window);
+    }
+    else
+    {
+        reply("Streaming mode disabled.\n");
+    }
+}
+
+// Word ids are ints, so a long stream renumbers its words before they
+// overflow. Taking a multiple of the ring size off every id leaves each word
+// in its slot; cached matches are dropped and showrev rebuilds its tree.
+void rebaseWindow(WordList *list)
+{
+    int shift = list->base & ~list->mask;
+    list->base -= shift;
+    list->size -= shift;
+    for (ArenaChunk *chunk = list->chunks; chunk; chunk = chunk->next)
+    {
+        if (chunk->lastId != INT32_MAX)
+        {
+            chunk->lastId = chunk->lastId > shift ? chunk->lastId - shift : 0;
+        }
+    }
+    for (int i = 0; list->cache.entries && i < PATTERN_CACHE_SLOTS; i++)
+    {
+        list->cache.entries[i].size = 0;
+        list->cache.entries[i].scanned = list->base;
+        list->cache.entries[i].tailSize = 0;
+        list->cache.entries[i].tailFrom = list->cache.entries[i].tailTo = list->base;
+    }
+    list->order.window = 0;
+}
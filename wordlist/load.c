@@ -0,0 +1,351 @@
+// Loading and saving word lists as text.
+
+#include "wordlist.h"
+
+// A word found by a load worker, terminated and trimmed in place
+typedef struct
+{
+    char *word;
+    int valid;
+} LoadEntry;
+
+// A newline-aligned byte range of a load block and the words found in it
+typedef struct
+{
+    char *begin;
+    char *end;
+    LoadEntry *entries;
+    int size;
+    int capacity;
+} LoadChunk;
+
+// Hands blocks of the file from the reader thread to the loader one at a
+// time, so the next block is read while the current one is processed
+typedef struct
+{
+    int fd;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    ArenaChunk *pending;
+    int done;
+    int failed;
+} LoadReader;
+
+void load(WordList *list, const char *filename)
+{
+    char *trimmed = trim((char *)filename);
+    if (strlen(trimmed) == 0)
+    {
+        replyError("Error: Invalid filename\n");
+        return;
+    }
+    FILE *file = fopen(trimmed, "r");
+    if (!file)
+    {
+        replyError("Cannot open file '%s'.\n", trimmed);
+        return;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int before = list->size;
+    int rejected = 0;
+    if (list->threads > 1 && loadParallel(list, fileno(file), &rejected))
+    {
+        fclose(file);
+        printLoadSummary(list->size - before, rejected, trimmed, &start);
+        return;
+    }
+    // Each line is one word, however long it is
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    while (getline(&line, &lineCapacity, file) >= 0)
+    {
+        line[strcspn(line, "\n")] = 0;
+        list->stats.bytesRead += strlen(line) + 1;
+        char *word = trim(line);
+        if (*word && !addWord(list, word, 1, !list->quiet))
+        {
+            rejected++;
+        }
+    }
+    free(line);
+    fclose(file);
+    printLoadSummary(list->size - before, rejected, trimmed, &start);
+}
+
+// Reader thread: fill blocks with whole lines. The partial line at the end
+// of a block is carried to the start of the next one; a block is only
+// ever cut inside a line when it is the last one.
+static void *readBlocks(void *arg)
+{
+    LoadReader *reader = (LoadReader *)arg;
+    char *carry = NULL;
+    size_t carryLength = 0;
+    ArenaChunk *carryChunk = NULL;
+    int eof = 0;
+    while (!eof)
+    {
+        size_t capacity = carryLength + LOAD_BLOCK_SIZE;
+        // One spare byte terminates an unterminated last line
+        ArenaChunk *chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + capacity + 1);
+        if (!chunk)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        char *data = (char *)(chunk + 1);
+        if (carryLength)
+        {
+            memcpy(data, carry, carryLength);
+        }
+        free(carryChunk);
+        carryChunk = NULL;
+        size_t used = carryLength;
+        while (used < capacity)
+        {
+            ssize_t got = read(reader->fd, data + used, capacity - used);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0)
+            {
+                eof = 1;
+                reader->failed = got < 0;
+                break;
+            }
+            used += (size_t)got;
+        }
+        chunk->capacity = used;
+        chunk->used = used;
+        carry = NULL;
+        carryLength = 0;
+        if (!eof)
+        {
+            size_t lineEnd = used;
+            while (lineEnd > 0 && data[lineEnd - 1] != '\n') lineEnd--;
+            carry = data + lineEnd;
+            carryLength = used - lineEnd;
+            chunk->used = lineEnd;
+            if (lineEnd == 0)
+            {
+                // A single line longer than the block: read on into a bigger one
+                carryChunk = chunk;
+                continue;
+            }
+        }
+        if (chunk->used == 0)
+        {
+            free(chunk);
+            continue;
+        }
+        pthread_mutex_lock(&reader->lock);
+        while (reader->pending)
+        {
+            pthread_cond_wait(&reader->changed, &reader->lock);
+        }
+        reader->pending = chunk;
+        pthread_cond_broadcast(&reader->changed);
+        pthread_mutex_unlock(&reader->lock);
+    }
+    pthread_mutex_lock(&reader->lock);
+    reader->done = 1;
+    pthread_cond_broadcast(&reader->changed);
+    pthread_mutex_unlock(&reader->lock);
+    return NULL;
+}
+
+static void addLoadEntry(LoadChunk *chunk, char *word, int valid)
+{
+    if (chunk->size >= chunk->capacity)
+    {
+        chunk->capacity = chunk->capacity ? chunk->capacity * 2 : 1024;
+        chunk->entries = (LoadEntry *)realloc(chunk->entries, chunk->capacity * sizeof(LoadEntry));
+        if (!chunk->entries)
+        {
+            fprintf(stderr, "Memory reallocation failed\n");
+            exit(1);
+        }
+    }
+    LoadEntry *entry = &chunk->entries[chunk->size++];
+    entry->word = word;
+    entry->valid = valid;
+}
+
+// Load worker: split a range into lines and trim and validate each one
+static void *parseChunk(void *arg)
+{
+    LoadChunk *chunk = (LoadChunk *)arg;
+    chunk->size = 0;
+    for (char *line = chunk->begin; line < chunk->end;)
+    {
+        char *newline = (char *)memchr(line, '\n', chunk->end - line);
+        char *lineEnd = newline ? newline : chunk->end;
+        // The block's spare byte makes room past an unterminated last line
+        *lineEnd = 0;
+        char *word = trim(line);
+        if (*word)
+        {
+            addLoadEntry(chunk, word, validateWord(word, 0));
+        }
+        line = lineEnd + 1;
+    }
+    return NULL;
+}
+
+// load() with several threads: a reader thread reads the file in large
+// blocks while the previous block is split into one newline-aligned range
+// per thread, and the words of the ranges are appended in file order, so
+// the result is the same as the serial loop. Each block becomes an arena
+// chunk of the list and its words stay where they were read. Returns 0 if
+// the reader thread could not be started and nothing was loaded.
+int loadParallel(WordList *list, int fd, int *rejected)
+{
+    LoadReader reader;
+    reader.fd = fd;
+    reader.pending = NULL;
+    reader.done = 0;
+    reader.failed = 0;
+    pthread_mutex_init(&reader.lock, NULL);
+    pthread_cond_init(&reader.changed, NULL);
+    pthread_t readerThread;
+    if (pthread_create(&readerThread, NULL, readBlocks, &reader) != 0)
+    {
+        pthread_mutex_destroy(&reader.lock);
+        pthread_cond_destroy(&reader.changed);
+        return 0;
+    }
+
+    int threads = list->threads;
+    LoadChunk chunks[MAX_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    ArenaChunk *previous = NULL;
+    while (1)
+    {
+        pthread_mutex_lock(&reader.lock);
+        while (!reader.pending && !reader.done)
+        {
+            pthread_cond_wait(&reader.changed, &reader.lock);
+        }
+        ArenaChunk *block = reader.pending;
+        reader.pending = NULL;
+        pthread_cond_broadcast(&reader.changed);
+        pthread_mutex_unlock(&reader.lock);
+        if (!block)
+        {
+            break;
+        }
+        // Behind the current arena chunk, so arenaAlloc() keeps filling that
+        // one; the carried partial line past `used` is not part of the block.
+        // A compressed list copies the words out and frees the block instead,
+        // once the next one shows the reader has copied that line out of it.
+        block->capacity = block->used;
+        block->lastId = INT32_MAX;
+        if (!list->packed.blocks)
+        {
+            if (!list->chunks)
+            {
+                arenaAlloc(list, 0);
+            }
+            block->next = list->chunks->next;
+            list->chunks->next = block;
+        }
+        list->stats.bytesRead += block->used;
+
+        char *data = (char *)(block + 1);
+        char *end = data + block->used;
+        char *begin = data;
+        for (int t = 0; t < threads; t++)
+        {
+            char *cut = t == threads - 1 ? end : data + block->used / threads * (t + 1);
+            if (cut < begin) cut = begin;
+            while (cut < end && cut[-1] != '\n') cut++;
+            chunks[t].begin = begin;
+            chunks[t].end = cut;
+            begin = cut;
+        }
+        runChunks(chunks, sizeof(LoadChunk), threads, parseChunk);
+
+        for (int t = 0; t < threads; t++)
+        {
+            for (int k = 0; k < chunks[t].size; k++)
+            {
+                LoadEntry *entry = &chunks[t].entries[k];
+                if (entry->valid)
+                {
+                    appendWord(list, entry->word, 0);
+                    if (!list->quiet)
+                    {
+                        reply("Inserted: %s\n", entry->word);
+                    }
+                }
+                else
+                {
+                    (*rejected)++;
+                    if (!list->quiet)
+                    {
+                        validateWord(entry->word, 1);
+                    }
+                }
+            }
+        }
+        if (list->packed.blocks)
+        {
+            free(previous);
+            previous = block;
+            continue;
+        }
+        block->lastId = list->size;
+        releaseChunks(list);
+    }
+    free(previous);
+    pthread_join(readerThread, NULL);
+    pthread_mutex_destroy(&reader.lock);
+    pthread_cond_destroy(&reader.changed);
+    for (int t = 0; t < threads; t++)
+    {
+        free(chunks[t].entries);
+    }
+    if (reader.failed)
+    {
+        replyError("Error: Reading stopped early\n");
+    }
+    return 1;
+}
+
+void save(WordList *list, const char *filename)
+{
+    char *trimmed = trim((char *)filename);
+    if (strlen(trimmed) == 0)
+    {
+        replyError("Error: Invalid filename\n");
+        return;
+    }
+    FILE *file = fopen(trimmed, "w");
+    if (!file)
+    {
+        replyError("Cannot open file '%s'.\n", trimmed);
+        return;
+    }
+    for (int i = list->base; i < list->size; i++)
+    {
+        fprintf(file, "%s\n", wordAt(list, i));
+        list->stats.bytesWritten += strlen(wordAt(list, i)) + 1;
+    }
+    fclose(file);
+    reply("Saved words to '%s'.\n", trimmed);
+}
+
+double elapsedMs(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+void printLoadSummary(int loaded, int rejected, const char *filename, const struct timespec *start)
+{
+    reply("Loaded %d words from '%s' in %.1f ms", loaded, filename, elapsedMs(start));
+    if (rejected > 0)
+    {
+        reply(" (%d rejected)", rejected);
+    }
+    reply(".\n");
+}
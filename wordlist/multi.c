@@ -0,0 +1,399 @@
+// findmulti and findmultirev through Aho-Corasick automata.
+
+#include "wordlist.h"
+
+// One thread's share of a findmulti scan: how many of its words complete
+// each state
+typedef struct
+{
+    const WordList *list;
+    const Matcher *matcher;
+    int begin;
+    int end;
+    int *counts;
+    int *seen;
+} MultiChunk;
+
+// Compile patterns into matcher. The trie is built in the transition table
+// first; a breadth-first pass then sets each state's failure link and
+// fills in its missing transitions from the failure state's, which is
+// shallower and so already complete.
+void buildMatcher(Matcher *matcher, char **patterns, int count)
+{
+    unsigned char classId[256] = {0};
+    int classes = 0;
+    size_t total = 1;
+    for (int p = 0; p < count; p++)
+    {
+        for (const unsigned char *c = (const unsigned char *)patterns[p]; *c; c++)
+        {
+            unsigned char folded = foldByte(*c);
+            if (!classId[folded])
+            {
+                classId[folded] = (unsigned char)++classes;
+            }
+            total++;
+        }
+    }
+    for (int b = 0; b < 256; b++)
+    {
+        matcher->classOf[b] = classId[foldByte((unsigned char)b)];
+    }
+    int width = classes + 1;
+    matcher->patterns = count;
+    matcher->width = width;
+    matcher->next = (int *)calloc(total * width, sizeof(int));
+    matcher->fail = (int *)malloc(total * sizeof(int));
+    matcher->hit = (int *)malloc(total * sizeof(int));
+    matcher->ends = (int *)malloc(count * sizeof(int));
+    int *queue = (int *)malloc(total * sizeof(int));
+    if (!matcher->next || !matcher->fail || !matcher->hit || !matcher->ends || !queue)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    int *next = matcher->next;
+
+    // No trie edge leads back to the root, so 0 marks a missing one
+    int states = 1;
+    for (int p = 0; p < count; p++)
+    {
+        int state = 0;
+        for (const unsigned char *c = (const unsigned char *)patterns[p]; *c; c++)
+        {
+            int *edge = &next[state * width + matcher->classOf[*c]];
+            if (!*edge)
+            {
+                *edge = states++;
+            }
+            state = *edge;
+        }
+        matcher->ends[p] = state;
+    }
+    matcher->states = states;
+    for (int state = 0; state < states; state++)
+    {
+        matcher->hit[state] = -1;
+    }
+    for (int p = 0; p < count; p++)
+    {
+        matcher->hit[matcher->ends[p]] = matcher->ends[p];
+    }
+
+    int head = 0;
+    int tail = 0;
+    matcher->fail[0] = 0;
+    for (int c = 0; c < width; c++)
+    {
+        if (next[c])
+        {
+            matcher->fail[next[c]] = 0;
+            queue[tail++] = next[c];
+        }
+    }
+    while (head < tail)
+    {
+        int state = queue[head++];
+        int fail = matcher->fail[state];
+        if (matcher->hit[state] < 0)
+        {
+            matcher->hit[state] = matcher->hit[fail];
+        }
+        for (int c = 0; c < width; c++)
+        {
+            int child = next[state * width + c];
+            if (child)
+            {
+                matcher->fail[child] = next[fail * width + c];
+                queue[tail++] = child;
+            }
+            else
+            {
+                next[state * width + c] = next[fail * width + c];
+            }
+        }
+    }
+    free(queue);
+}
+
+// The compiled matcher for patterns, whose folded text is key. The least
+// recently used one is replaced when none matches.
+Matcher *lookupMatcher(WordList *list, const char *key, char **patterns, int count)
+{
+    MatcherCache *cache = &list->matchers;
+    if (!cache->entries)
+    {
+        cache->entries = (Matcher *)calloc(MATCHER_CACHE_SLOTS, sizeof(Matcher));
+        if (!cache->entries)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    Matcher *victim = &cache->entries[0];
+    for (int i = 0; i < MATCHER_CACHE_SLOTS; i++)
+    {
+        Matcher *entry = &cache->entries[i];
+        if (entry->key && strcmp(entry->key, key) == 0)
+        {
+            entry->lastUsed = ++cache->clock;
+            return entry;
+        }
+        if (!entry->key || (victim->key && entry->lastUsed < victim->lastUsed))
+        {
+            victim = entry;
+        }
+    }
+    free(victim->key);
+    free(victim->next);
+    free(victim->fail);
+    free(victim->hit);
+    free(victim->ends);
+    victim->key = strdup(key);
+    if (!victim->key)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    buildMatcher(victim, patterns, count);
+    victim->lastUsed = ++cache->clock;
+    return victim;
+}
+
+void freeMatchers(WordList *list)
+{
+    MatcherCache *cache = &list->matchers;
+    if (!cache->entries)
+    {
+        return;
+    }
+    for (int i = 0; i < MATCHER_CACHE_SLOTS; i++)
+    {
+        free(cache->entries[i].key);
+        free(cache->entries[i].next);
+        free(cache->entries[i].fail);
+        free(cache->entries[i].hit);
+        free(cache->entries[i].ends);
+    }
+    free(cache->entries);
+    cache->entries = NULL;
+}
+
+// Run the words [begin, end) through the matcher, backwards when reverse is
+// set, adding one to counts[s] for every word that completes state s
+// (seen[s] holds the last such word, so a word counts once). With want
+// given, a state whose count reaches want[s] records the word in found[s],
+// and the scan stops once pending states have. Returns the words scanned.
+int scanMulti(const WordList *list, const Matcher *matcher, int begin, int end, int reverse, const int *want, int *counts, int *seen, int *found, int pending)
+{
+    const int *next = matcher->next;
+    const int *hit = matcher->hit;
+    int width = matcher->width;
+    for (int k = begin; k < end; k++)
+    {
+        int i = reverse ? end - 1 - (k - begin) : k;
+        int state = 0;
+        for (const unsigned char *c = (const unsigned char *)foldAt(list, i); *c; c++)
+        {
+            state = next[state * width + matcher->classOf[*c]];
+            for (int s = hit[state]; s >= 0; s = hit[matcher->fail[s]])
+            {
+                if (seen[s] == i)
+                {
+                    continue;
+                }
+                seen[s] = i;
+                if (++counts[s] == (want ? want[s] : 0))
+                {
+                    found[s] = i;
+                    if (--pending == 0)
+                    {
+                        return k - begin + 1;
+                    }
+                }
+            }
+        }
+    }
+    return end - begin;
+}
+
+static void *countMultiChunk(void *arg)
+{
+    MultiChunk *chunk = (MultiChunk *)arg;
+    scanMulti(chunk->list, chunk->matcher, chunk->begin, chunk->end, 0, NULL, chunk->counts, chunk->seen, NULL, 0);
+    return NULL;
+}
+
+// Set found[s] to the nth word completing each pattern-ending state s, or
+// -1. Large lists are counted in one chunk per thread like findNthParallel;
+// a chunk holding the nth match of some patterns is then scanned once more
+// for all of them.
+void findMulti(WordList *list, const Matcher *matcher, int n, int reverse, int *found)
+{
+    int states = matcher->states;
+    int *want = (int *)calloc(states, sizeof(int));
+    int *counts = (int *)calloc(states, sizeof(int));
+    int *seen = (int *)malloc(states * sizeof(int));
+    if (!want || !counts || !seen)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    int pending = 0;
+    for (int s = 0; s < states; s++)
+    {
+        found[s] = -1;
+        seen[s] = -1;
+        if (matcher->hit[s] == s)
+        {
+            want[s] = n;
+            pending++;
+        }
+    }
+    int words = wordCount(list);
+    if (list->threads > 1 && words >= PARALLEL_MIN_WORDS)
+    {
+        int threads = list->threads;
+        MultiChunk chunks[MAX_THREADS];
+        for (int t = 0; t < threads; t++)
+        {
+            chunks[t].list = list;
+            chunks[t].matcher = matcher;
+            chunks[t].begin = list->base + (int)((long long)words * t / threads);
+            chunks[t].end = list->base + (int)((long long)words * (t + 1) / threads);
+            chunks[t].counts = (int *)calloc(states, sizeof(int));
+            chunks[t].seen = (int *)malloc(states * sizeof(int));
+            if (!chunks[t].counts || !chunks[t].seen)
+            {
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(1);
+            }
+            memset(chunks[t].seen, 0xff, states * sizeof(int));
+        }
+        runChunks(chunks, sizeof(MultiChunk), threads, countMultiChunk);
+        list->stats.wordsScanned += words;
+
+        // counts holds the matches before the current chunk, in scan order
+        for (int k = 0; k < threads && pending > 0; k++)
+        {
+            const MultiChunk *chunk = &chunks[reverse ? threads - 1 - k : k];
+            int resolving = 0;
+            for (int s = 0; s < states; s++)
+            {
+                int resolves = found[s] < 0 && matcher->hit[s] == s && counts[s] + chunk->counts[s] >= n;
+                want[s] = resolves ? n - counts[s] : 0;
+                resolving += resolves;
+                counts[s] += chunk->counts[s];
+            }
+            if (resolving)
+            {
+                memset(chunk->seen, 0xff, states * sizeof(int));
+                memset(chunk->counts, 0, states * sizeof(int));
+                list->stats.wordsScanned += scanMulti(list, matcher, chunk->begin, chunk->end, reverse, want,
+                                                      chunk->counts, chunk->seen, found, resolving);
+                pending -= resolving;
+            }
+        }
+        for (int t = 0; t < threads; t++)
+        {
+            free(chunks[t].counts);
+            free(chunks[t].seen);
+        }
+    }
+    else
+    {
+        list->stats.wordsScanned += scanMulti(list, matcher, list->base, list->size, reverse, want, counts, seen, found, pending);
+    }
+    free(want);
+    free(counts);
+    free(seen);
+}
+
+// Report the nth occurrence of each whitespace-separated pattern in text,
+// as findfwd and findrev would, after a single scan of the list
+static void reportMulti(WordList *list, const char *text, int n, int reverse)
+{
+    if (n <= 0)
+    {
+        replyError("Error: Invalid occurrence number %d\n", n);
+        return;
+    }
+    size_t length = strlen(text);
+    char *copy = (char *)malloc(length + 1);
+    char *foldedText = (char *)malloc(2 * length + 2);
+    char *key = (char *)malloc(2 * length + 2);
+    char **patterns = (char **)malloc((length / 2 + 1) * sizeof(char *));
+    char **folded = (char **)malloc((length / 2 + 1) * sizeof(char *));
+    if (!copy || !foldedText || !key || !patterns || !folded)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(copy, text, length + 1);
+
+    // The folded patterns are packed into foldedText, and the cache key is
+    // the same text with spaces between them
+    int count = 0;
+    size_t foldedLength = 0;
+    for (char *c = copy; *c;)
+    {
+        while (isspace((unsigned char)*c)) c++;
+        if (!*c)
+        {
+            break;
+        }
+        char *start = c;
+        while (*c && !isspace((unsigned char)*c)) c++;
+        patterns[count] = start;
+        folded[count++] = foldedText + foldedLength;
+        foldedLength += foldText(start, c - start, foldedText + foldedLength, NULL) + 1;
+        if (*c)
+        {
+            *c++ = 0;
+        }
+    }
+    key[0] = 0;
+    memcpy(key, foldedText, foldedLength);
+    for (size_t k = 0; k + 1 < foldedLength; k++)
+    {
+        if (!key[k]) key[k] = ' ';
+    }
+
+    const Matcher *matcher = lookupMatcher(list, key, folded, count);
+    int *found = (int *)malloc(matcher->states * sizeof(int));
+    if (!found)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    list->stats.finds += count;
+    findMulti(list, matcher, n, reverse, found);
+    for (int p = 0; p < count; p++)
+    {
+        int i = found[matcher->ends[p]];
+        if (i >= 0)
+        {
+            reply("Found '%s' at index %d: %s\n", patterns[p], i - list->base, wordAt(list, i));
+        }
+        else
+        {
+            reply("No %dth occurrence of '%s' found.\n", n, patterns[p]);
+        }
+    }
+    free(found);
+    free(folded);
+    free(patterns);
+    free(key);
+    free(foldedText);
+    free(copy);
+}
+
+void findmulti(WordList *list, const char *patterns, int n)
+{
+    reportMulti(list, patterns, n, 0);
+}
+
+void findmultirev(WordList *list, const char *patterns, int n)
+{
+    reportMulti(list, patterns, n, 1);
+}
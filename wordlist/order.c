@@ -0,0 +1,315 @@
+// showrev: the most recent words in reverse alphabetical order.
+
+#include "wordlist.h"
+
+// The first 8 bytes of a folded word, big-endian and zero padded, so
+// comparing two keys as integers orders the words by those bytes. A key
+// whose low byte is zero covers its whole word.
+uint64_t sortKey(const char *word)
+{
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && word[i]; i++)
+    {
+        key = key << 8 | (unsigned char)word[i];
+    }
+    for (; i < 8; i++)
+    {
+        key <<= 8;
+    }
+    return key;
+}
+
+// showrev order: reverse alphabetical ignoring case, and words that compare
+// equal keep their insertion order. The keys settle most comparisons; only
+// words sharing their first 8 folded bytes are compared further.
+int orderBefore(const WordList *list, int a, int b)
+{
+    uint64_t keyA = keyAt(list, a);
+    uint64_t keyB = keyAt(list, b);
+    if (keyA != keyB)
+    {
+        return keyA > keyB;
+    }
+    int cmp = (keyA & 0xFF) ? strcmp(foldAt(list, b) + 8, foldAt(list, a) + 8) : 0;
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+// Sort ids (ascending on entry) into showrev order, given each word's next
+// 8 folded bytes from `depth` in keys. A byte-wise LSD radix sort orders
+// that digit descending and keeps equal ones in id order; runs that tie on
+// a digit without ending the word move on to the next 8 bytes (MSD order).
+void sortOrder(const WordList *list, int *ids, uint64_t *keys, int n, size_t depth, int *idScratch, uint64_t *keyScratch)
+{
+    if (n < 32)
+    {
+        for (int i = 1; i < n; i++)
+        {
+            int id = ids[i];
+            uint64_t key = keys[i];
+            int j = i;
+            for (; j > 0 && orderBefore(list, id, ids[j - 1]); j--)
+            {
+                ids[j] = ids[j - 1];
+                keys[j] = keys[j - 1];
+            }
+            ids[j] = id;
+            keys[j] = key;
+        }
+        return;
+    }
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        int counts[256] = {0};
+        for (int i = 0; i < n; i++)
+        {
+            counts[keys[i] >> shift & 0xFF]++;
+        }
+        if (counts[keys[0] >> shift & 0xFF] == n)
+        {
+            continue;
+        }
+        // Larger bytes first
+        int position = 0;
+        for (int b = 255; b >= 0; b--)
+        {
+            int count = counts[b];
+            counts[b] = position;
+            position += count;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int at = counts[keys[i] >> shift & 0xFF]++;
+            idScratch[at] = ids[i];
+            keyScratch[at] = keys[i];
+        }
+        memcpy(ids, idScratch, n * sizeof(int));
+        memcpy(keys, keyScratch, n * sizeof(uint64_t));
+    }
+    for (int i = 0; i < n;)
+    {
+        int j = i + 1;
+        while (j < n && keys[j] == keys[i]) j++;
+        if (j - i > 1 && (keys[i] & 0xFF))
+        {
+            for (int k = i; k < j; k++)
+            {
+                keys[k] = sortKey(foldAt(list, ids[k]) + depth + 8);
+            }
+            sortOrder(list, ids + i, keys + i, j - i, depth + 8, idScratch, keyScratch);
+        }
+        i = j;
+    }
+}
+
+// Build the treap over ids, already in showrev order, in one pass: each node
+// takes over the nodes of lower priority on the right spine as its left subtree
+OrderNode *buildOrder(const WordList *list, OrderNode *nodes, const int *ids, int n)
+{
+    OrderNode **spine = (OrderNode **)malloc((n + 1) * sizeof(OrderNode *));
+    if (!spine)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    int depth = 0;
+    for (int i = 0; i < n; i++)
+    {
+        OrderNode *node = &nodes[ids[i] % list->order.window];
+        OrderNode *last = NULL;
+        while (depth > 0 && spine[depth - 1]->priority < node->priority)
+        {
+            last = spine[--depth];
+        }
+        node->left = last;
+        node->right = NULL;
+        if (depth > 0)
+        {
+            spine[depth - 1]->right = node;
+        }
+        spine[depth++] = node;
+    }
+    OrderNode *root = depth > 0 ? spine[0] : NULL;
+    free(spine);
+    return root;
+}
+
+static OrderNode *rotateRight(OrderNode *node)
+{
+    OrderNode *left = node->left;
+    node->left = left->right;
+    left->right = node;
+    return left;
+}
+
+static OrderNode *rotateLeft(OrderNode *node)
+{
+    OrderNode *right = node->right;
+    node->right = right->left;
+    right->left = node;
+    return right;
+}
+
+OrderNode *orderInsert(const WordList *list, OrderNode *root, OrderNode *node)
+{
+    if (!root)
+    {
+        return node;
+    }
+    if (orderBefore(list, node->id, root->id))
+    {
+        root->left = orderInsert(list, root->left, node);
+        if (root->left->priority > root->priority)
+        {
+            root = rotateRight(root);
+        }
+    }
+    else
+    {
+        root->right = orderInsert(list, root->right, node);
+        if (root->right->priority > root->priority)
+        {
+            root = rotateLeft(root);
+        }
+    }
+    return root;
+}
+
+OrderNode *orderRemove(const WordList *list, OrderNode *root, int id)
+{
+    if (!root)
+    {
+        return NULL;
+    }
+    if (root->id != id)
+    {
+        if (orderBefore(list, id, root->id))
+        {
+            root->left = orderRemove(list, root->left, id);
+        }
+        else
+        {
+            root->right = orderRemove(list, root->right, id);
+        }
+        return root;
+    }
+    // Rotate the node down until it has at most one child, then splice it out
+    if (!root->left)
+    {
+        return root->right;
+    }
+    if (!root->right)
+    {
+        return root->left;
+    }
+    if (root->left->priority > root->right->priority)
+    {
+        root = rotateRight(root);
+        root->right = orderRemove(list, root->right, id);
+    }
+    else
+    {
+        root = rotateLeft(root);
+        root->left = orderRemove(list, root->left, id);
+    }
+    return root;
+}
+
+// Bring the ordered window up to date for `showrev window`. Words inserted
+// since the last call are added and the ones that slid out are removed, a
+// logarithmic step each; asking for a different window rebuilds the tree.
+void syncShowrevOrder(WordList *list, int window)
+{
+    ShowrevOrder *order = &list->order;
+    if (order->window != window || list->size - order->upto > window)
+    {
+        free(order->nodes);
+        order->nodes = (OrderNode *)malloc(window * sizeof(OrderNode));
+        if (!order->nodes)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        order->window = window;
+        // Rebuilding sorts the whole window at once instead of inserting
+        // its words one by one
+        int first = list->size > window ? list->size - window : 0;
+        int n = list->size - first;
+        int *ids = (int *)malloc(2 * (size_t)n * sizeof(int));
+        uint64_t *keys = (uint64_t *)malloc(2 * (size_t)n * sizeof(uint64_t));
+        if (!ids || !keys)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        for (int k = 0; k < n; k++)
+        {
+            int id = first + k;
+            ids[k] = id;
+            keys[k] = keyAt(list, id);
+            order->seed ^= order->seed << 13;
+            order->seed ^= order->seed >> 17;
+            order->seed ^= order->seed << 5;
+            order->nodes[id % window].priority = order->seed;
+            order->nodes[id % window].id = id;
+        }
+        sortOrder(list, ids, keys, n, 0, ids + n, keys + n);
+        order->root = buildOrder(list, order->nodes, ids, n);
+        order->upto = list->size;
+        free(ids);
+        free(keys);
+        return;
+    }
+    for (int id = order->upto; id < list->size; id++)
+    {
+        OrderNode *node = &order->nodes[id % window];
+        if (id >= window)
+        {
+            order->root = orderRemove(list, order->root, id - window);
+        }
+        order->seed ^= order->seed << 13;
+        order->seed ^= order->seed >> 17;
+        order->seed ^= order->seed << 5;
+        node->left = NULL;
+        node->right = NULL;
+        node->priority = order->seed;
+        node->id = id;
+        order->root = orderInsert(list, order->root, node);
+    }
+    order->upto = list->size;
+}
+
+static int printOrder(const WordList *list, const OrderNode *node, int rank)
+{
+    if (!node)
+    {
+        return rank;
+    }
+    rank = printOrder(list, node->left, rank);
+    reply("%-4d %s\n", ++rank, wordAt(list, node->id));
+    return printOrder(list, node->right, rank);
+}
+
+void showrev(WordList *list, int n)
+{
+    if (n <= 0)
+    {
+        replyError("Error: Invalid number of words %d\n", n);
+        return;
+    }
+    if (wordCount(list) == 0)
+    {
+        reply("No words to display.\n");
+        return;
+    }
+    // A streaming window has no more words to show
+    if (list->window && n > list->window)
+    {
+        n = list->window;
+    }
+    // The order holds no more nodes than there are words to show
+    n = (n > wordCount(list)) ? wordCount(list) : n;
+    syncShowrevOrder(list, n);
+    reply("Last %d words in reverse alphabetical order:\n", n);
+    printOrder(list, list->order.root, 0);
+}
@@ -0,0 +1,318 @@
+// Compression: front-coded blocks of words, decoded on demand.
+
+#include "wordlist.h"
+
+static unsigned char *putVarint(unsigned char *out, size_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+static const unsigned char *getVarint(const unsigned char *in, size_t *value)
+{
+    size_t result = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        result |= (size_t)(*in & 0x7F) << shift;
+        if (!(*in++ & 0x80))
+        {
+            break;
+        }
+    }
+    *value = result;
+    return in;
+}
+
+// Add word to the last block of a compressed list, starting a new block
+// every PACK_BLOCK_WORDS words. A full block is moved into the arena, which
+// packs blocks back to back.
+void packWord(WordList *list, const char *word)
+{
+    PackedStore *packed = &list->packed;
+    int k = packed->size & (PACK_BLOCK_WORDS - 1);
+    if (k == 0)
+    {
+        if (packed->count >= packed->capacity)
+        {
+            packed->capacity *= 2;
+            packed->blocks = (PackedBlock *)realloc(packed->blocks, packed->capacity * sizeof(PackedBlock));
+            if (!packed->blocks)
+            {
+                fprintf(stderr, "Memory reallocation failed\n");
+                exit(1);
+            }
+        }
+        memset(&packed->blocks[packed->count], 0, sizeof(PackedBlock));
+        packed->blocks[packed->count++].textLength = 1;
+    }
+    PackedBlock *block = &packed->blocks[packed->count - 1];
+    size_t len = strlen(word);
+    size_t shared = 0;
+    while (k > 0 && shared < len && packed->last[shared] == word[shared]) shared++;
+    size_t rest = len - shared;
+
+    size_t need = block->length + 1 + 2 * 10 + rest;
+    if (need > packed->openCapacity)
+    {
+        packed->openCapacity = need > 2 * packed->openCapacity ? need : 2 * packed->openCapacity;
+        packed->open = (unsigned char *)realloc(packed->open, packed->openCapacity);
+        if (!packed->open)
+        {
+            fprintf(stderr, "Memory reallocation failed\n");
+            exit(1);
+        }
+    }
+    unsigned char *out = packed->open + block->length;
+    if (shared < 15 && rest < 16)
+    {
+        *out++ = (unsigned char)(shared << 4 | rest);
+    }
+    else
+    {
+        *out++ = 0xF0;
+        out = putVarint(out, shared);
+        out = putVarint(out, rest);
+    }
+    memcpy(out, word + shared, rest);
+    block->length = out + rest - packed->open;
+    block->data = packed->open;
+    block->textLength += 3 * (len + 1);
+
+    char buffer[FOLD_BUFFER_SIZE];
+    char *folded = foldPattern(word, buffer);
+    block->mask |= wordSignature(folded);
+    if (folded != buffer)
+    {
+        free(folded);
+    }
+
+    if (len + 1 > packed->lastCapacity)
+    {
+        packed->lastCapacity = 2 * (len + 1);
+        free(packed->last);
+        packed->last = (char *)malloc(packed->lastCapacity);
+        if (!packed->last)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    memcpy(packed->last, word, len + 1);
+    packed->size++;
+    if (k == PACK_BLOCK_WORDS - 1)
+    {
+        block->data = (unsigned char *)arenaAlloc(list, block->length);
+        memcpy(block->data, packed->open, block->length);
+    }
+}
+
+static __thread DecodedBlock *decodedBlocks;
+static __thread DecodedBlock *decodedLast;
+static __thread uint64_t decodedClock;
+static pthread_key_t decodedKey;
+static pthread_once_t decodedOnce = PTHREAD_ONCE_INIT;
+static uint64_t packGeneration;
+
+static void freeDecoded(void *blocks)
+{
+    DecodedBlock *decoded = (DecodedBlock *)blocks;
+    for (int i = 0; i < PACK_DECODE_SLOTS; i++)
+    {
+        free(decoded[i].text);
+    }
+    free(decoded);
+}
+
+// The decoded blocks are per thread, and freed when a scan's thread exits
+static void createDecodedKey(void)
+{
+    pthread_key_create(&decodedKey, freeDecoded);
+}
+
+// Decode block of a compressed list, or find it among the blocks this
+// thread decoded last. The last block counts as another one whenever it
+// has grown since.
+const DecodedBlock *decodeBlock(const WordList *list, int block)
+{
+    const PackedStore *packed = &list->packed;
+    int words = packed->size - block * PACK_BLOCK_WORDS;
+    words = words < PACK_BLOCK_WORDS ? words : PACK_BLOCK_WORDS;
+    if (!decodedBlocks)
+    {
+        pthread_once(&decodedOnce, createDecodedKey);
+        decodedBlocks = (DecodedBlock *)calloc(PACK_DECODE_SLOTS, sizeof(DecodedBlock));
+        if (!decodedBlocks)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+        pthread_setspecific(decodedKey, decodedBlocks);
+    }
+    DecodedBlock *last = decodedLast;
+    if (last && last->block == block && last->generation == packed->generation && last->words == words)
+    {
+        return last;
+    }
+    DecodedBlock *victim = &decodedBlocks[0];
+    for (int i = 0; i < PACK_DECODE_SLOTS; i++)
+    {
+        DecodedBlock *decoded = &decodedBlocks[i];
+        if (decoded->block == block && decoded->generation == packed->generation && decoded->words == words)
+        {
+            decoded->used = ++decodedClock;
+            decodedLast = decoded;
+            return decoded;
+        }
+        if (decoded->used < victim->used)
+        {
+            victim = decoded;
+        }
+    }
+
+    const PackedBlock *source = &packed->blocks[block];
+    if (source->textLength > victim->capacity)
+    {
+        free(victim->text);
+        victim->capacity = source->textLength;
+        victim->text = (char *)malloc(victim->capacity);
+        if (!victim->text)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    const unsigned char *in = source->data;
+    char *out = victim->text;
+    for (int k = 0; k < words; k++)
+    {
+        size_t shared = *in >> 4;
+        size_t rest = *in & 0x0F;
+        in++;
+        if (shared == 15)
+        {
+            in = getVarint(in, &shared);
+            in = getVarint(in, &rest);
+        }
+        size_t len = shared + rest;
+        if (shared)
+        {
+            memcpy(out, victim->word[k - 1], shared);
+        }
+        memcpy(out + shared, in, rest);
+        in += rest;
+        out[len] = 0;
+        victim->word[k] = out;
+        out += len + 1;
+    }
+    // The words are folded in one go, NULs and all, so short words still
+    // fill whole SIMD blocks
+    int changed;
+    foldText(victim->text, out - victim->text, out, &changed);
+    for (int k = 0; k < words; k++)
+    {
+        victim->fold[k] = changed ? out : victim->word[k];
+        out += changed ? strlen(out) + 1 : 0;
+    }
+    victim->generation = packed->generation;
+    victim->block = block;
+    victim->words = words;
+    victim->used = ++decodedClock;
+    decodedLast = victim;
+    return victim;
+}
+
+// wordMatches() for a compressed list. The words of a block that lacks one
+// of the pattern's bytes cannot match, so the block is not decoded.
+int packedMatches(const WordList *list, int id, const char *pattern)
+{
+    int block = id >> PACK_BLOCK_BITS;
+    if (list->need & ~list->packed.blocks[block].mask)
+    {
+        return 0;
+    }
+    return strcasestr(decodeBlock(list, block)->fold[id & (PACK_BLOCK_WORDS - 1)], pattern) != NULL;
+}
+
+void freePacked(WordList *list)
+{
+    PackedStore *packed = &list->packed;
+    free(packed->blocks);
+    free(packed->open);
+    free(packed->last);
+    memset(packed, 0, sizeof(*packed));
+    if (decodedBlocks)
+    {
+        freeDecoded(decodedBlocks);
+        decodedBlocks = NULL;
+        decodedLast = NULL;
+        pthread_setspecific(decodedKey, NULL);
+    }
+}
+
+// Switch an empty list to keeping its words front coded in blocks, or back.
+// Words in sorted or clustered order share long prefixes, and even
+// unrelated ones then cost a byte or two over their text instead of the
+// pointers, sort key and allocation of a slot.
+// Start compressing the (empty) list's words
+void enablePacked(WordList *list)
+{
+    list->packed.capacity = INITIAL_CAPACITY;
+    list->packed.blocks = (PackedBlock *)malloc(list->packed.capacity * sizeof(PackedBlock));
+    if (!list->packed.blocks)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    list->packed.generation = ++packGeneration;
+}
+
+void setCompress(WordList *list, const char *mode)
+{
+    int on = strcmp(mode, "on") == 0;
+    if (!on && strcmp(mode, "off") != 0)
+    {
+        replyError("Error: Invalid compress mode '%s' (expected on/off)\n", mode);
+        return;
+    }
+    if (list->server)
+    {
+        replyError("Error: Compression cannot be changed while serving\n");
+        return;
+    }
+    if (list->size > 0)
+    {
+        replyError("Error: Compression has to be set before any words are added\n");
+        return;
+    }
+    if (on && list->window)
+    {
+        replyError("Error: Compression cannot be used in streaming mode\n");
+        return;
+    }
+    if (on && list->ids)
+    {
+        replyError("Error: Interning cannot be used with compression\n");
+        return;
+    }
+    if (on && !list->packed.blocks)
+    {
+        enablePacked(list);
+    }
+    else if (!on && list->packed.blocks)
+    {
+        freePacked(list);
+    }
+    if (on)
+    {
+        reply("Compression enabled (%d words per block).\n", PACK_BLOCK_WORDS);
+    }
+    else
+    {
+        reply("Compression disabled.\n");
+    }
+}
@@ -0,0 +1,269 @@
+// Serving the commands to clients of a Unix domain socket.
+
+#include "wordlist.h"
+
+// A client's list over the words the served list has published. The
+// segments and the substring index are shared and only read; the pattern
+// and matcher caches and the counters are the view's own, and last as long
+// as the client since words are only ever appended while serving. The
+// writer adds a segment before publishing a size that reaches into it, and
+// never changes it after.
+static void openView(WordList *view)
+{
+    memset(view, 0, sizeof(*view));
+    view->mask = -1;
+    view->threads = 1;
+    view->journal.fd = -1;
+}
+
+// Catch the view up with the words and settings published since last time
+static void refreshView(const WordList *list, WordList *view)
+{
+    view->size = __atomic_load_n(&list->size, __ATOMIC_ACQUIRE);
+    while (segmentStart(view->segments) < (uint32_t)view->size)
+    {
+        view->words[view->segments] = list->words[view->segments];
+        view->folds[view->segments] = list->folds[view->segments];
+        view->keys[view->segments] = list->keys[view->segments];
+        view->signatures[view->segments] = list->signatures[view->segments];
+        view->segments++;
+    }
+    view->capacity = view->size;
+    view->threads = __atomic_load_n(&list->threads, __ATOMIC_RELAXED);
+    // An index covers every word the writer has added, so it covers the view
+    view->trigrams = __atomic_load_n(&list->trigrams, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&list->cache.entries, __ATOMIC_RELAXED))
+    {
+        enableCache(view);
+    }
+    else
+    {
+        freeCache(view);
+    }
+}
+
+static void closeView(WordList *view)
+{
+    freeCache(view);
+    freeMatchers(view);
+}
+
+// Run one client line. Queries (and lines that are no command at all) run
+// on the client's view without waiting for the writer; anything else runs
+// as the single writer. Returns 1 when the client is done.
+static int serveLine(ServerClient *client, char *line)
+{
+    Server *server = client->server;
+    const char *name = line;
+    while (isspace((unsigned char)*name)) name++;
+    size_t length = 0;
+    while (name[length] && !isspace((unsigned char)name[length])) length++;
+    const Command *command = lookupCommand(name, length);
+    if (!command || command->query)
+    {
+        WordList *view = &client->view;
+        // showrev brings the list's order up to date for everyone. The view
+        // is refreshed inside the lock, so it is never older than the order.
+        int ordered = command && command->stat == STAT_SHOWREV;
+        if (ordered)
+        {
+            pthread_mutex_lock(&server->orderLock);
+            view->order = server->list->order;
+        }
+        refreshView(server->list, view);
+        int done = dispatchLine(view, line);
+        if (ordered)
+        {
+            server->list->order = view->order;
+            memset(&view->order, 0, sizeof(view->order));
+            pthread_mutex_unlock(&server->orderLock);
+        }
+        pthread_mutex_lock(&server->statsLock);
+        addStats(&server->stats, &view->stats);
+        pthread_mutex_unlock(&server->statsLock);
+        memset(&view->stats, 0, sizeof(view->stats));
+        return done;
+    }
+    pthread_mutex_lock(&server->writeLock);
+    int done = dispatchLine(server->list, line);
+    journalCommit(server->list);
+    pthread_mutex_unlock(&server->writeLock);
+    return done;
+}
+
+static void *serveClient(void *arg)
+{
+    ServerClient *client = (ServerClient *)arg;
+    openView(&client->view);
+    FILE *in = fdopen(client->fd, "r");
+    int outFd = in ? dup(client->fd) : -1;
+    replyStream = outFd >= 0 ? fdopen(outFd, "w") : NULL;
+    char line[MAX_LINE_LEN];
+    while (replyStream && fgets(line, sizeof(line), in))
+    {
+        line[strcspn(line, "\n")] = 0;
+        int done = serveLine(client, line);
+        // Each reply ends with a NUL byte, so clients know where it stops
+        fputc(0, replyStream);
+        if (fflush(replyStream) != 0 || done)
+        {
+            break;
+        }
+    }
+    if (replyStream)
+    {
+        fclose(replyStream);
+        replyStream = NULL;
+    }
+    else if (outFd >= 0)
+    {
+        close(outFd);
+    }
+    if (in)
+    {
+        fclose(in);
+    }
+    else
+    {
+        close(client->fd);
+    }
+    closeView(&client->view);
+    __atomic_store_n(&client->finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static volatile sig_atomic_t serverStopping = 0;
+
+static void stopServer(int signal)
+{
+    (void)signal;
+    serverStopping = 1;
+}
+
+// Serve the command set to clients of a Unix domain socket, one thread per
+// client, until SIGINT or SIGTERM. Returns 1 if the socket cannot be used.
+int runServer(WordList *list, const char *path)
+{
+    if (list->window || list->ids || list->packed.blocks)
+    {
+        fprintf(stderr, "Streaming mode, interning and compression cannot be used when serving\n");
+        return 1;
+    }
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path '%s' is too long\n", path);
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+    unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, MAX_CLIENTS) != 0)
+    {
+        fprintf(stderr, "Cannot listen on '%s'\n", path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    Server *server = (Server *)calloc(1, sizeof(Server));
+    if (!server)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    server->list = list;
+    server->fd = fd;
+    pthread_mutex_init(&server->writeLock, NULL);
+    pthread_mutex_init(&server->orderLock, NULL);
+    pthread_mutex_init(&server->statsLock, NULL);
+    list->server = server;
+
+    // No SA_RESTART, so a stop signal interrupts accept()
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopServer;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+
+    reply("Serving on '%s'.\n", path);
+    fflush(stdout);
+    while (!serverStopping)
+    {
+        int clientFd = accept(fd, NULL, NULL);
+        if (clientFd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "Cannot accept clients on '%s'\n", path);
+            break;
+        }
+        ServerClient *client = NULL;
+        for (int i = 0; i < MAX_CLIENTS; i++)
+        {
+            ServerClient *slot = &server->clients[i];
+            if (slot->active && __atomic_load_n(&slot->finished, __ATOMIC_ACQUIRE))
+            {
+                pthread_join(slot->thread, NULL);
+                slot->active = 0;
+            }
+            if (!slot->active && !client)
+            {
+                client = slot;
+            }
+        }
+        if (!client)
+        {
+            static const char busy[] = "Error: Too many clients\n";
+            send(clientFd, busy, sizeof(busy), MSG_NOSIGNAL);
+            close(clientFd);
+            continue;
+        }
+        client->server = server;
+        client->fd = clientFd;
+        client->finished = 0;
+        // Client threads block the stop signals, so they reach this thread
+        sigset_t previous;
+        pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+        client->active = pthread_create(&client->thread, NULL, serveClient, client) == 0;
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if (!client->active)
+        {
+            close(clientFd);
+        }
+    }
+
+    close(fd);
+    unlink(path);
+    for (int i = 0; i < MAX_CLIENTS; i++)
+    {
+        ServerClient *client = &server->clients[i];
+        if (client->active)
+        {
+            if (!__atomic_load_n(&client->finished, __ATOMIC_ACQUIRE))
+            {
+                shutdown(client->fd, SHUT_RDWR);
+            }
+            pthread_join(client->thread, NULL);
+        }
+    }
+    // Keep what the clients counted
+    addStats(&list->stats, &server->stats);
+    list->server = NULL;
+    for (int i = 0; i < server->retiredSize; i++)
+    {
+        free(server->retired[i]);
+    }
+    free(server->retired);
+    pthread_mutex_destroy(&server->writeLock);
+    pthread_mutex_destroy(&server->orderLock);
+    pthread_mutex_destroy(&server->statsLock);
+    free(server);
+    return 0;
+}
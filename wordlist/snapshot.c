@@ -0,0 +1,263 @@
+// Binary snapshots: savebin and loadbin.
+
+#include "wordlist.h"
+
+// Keep a file mapping alive until the list is freed
+void addMapping(WordList *list, void *addr, size_t length)
+{
+    Mapping *mapping = (Mapping *)malloc(sizeof(Mapping));
+    if (!mapping)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+    mapping->addr = addr;
+    mapping->length = length;
+    mapping->next = list->mappings;
+    list->mappings = mapping;
+}
+
+void checksumInit(Checksum *sum)
+{
+    sum->hash = 0xcbf29ce484222325ull;
+    sum->pending = 0;
+    sum->pendingBytes = 0;
+}
+
+static inline uint64_t checksumMix(uint64_t hash, uint64_t word)
+{
+    hash ^= word;
+    hash *= 0x100000001b3ull;
+    return hash ^ (hash >> 29);
+}
+
+void checksumUpdate(Checksum *sum, const void *data, size_t len)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    while (len > 0 && sum->pendingBytes > 0)
+    {
+        sum->pending |= (uint64_t)*bytes++ << (8 * sum->pendingBytes);
+        len--;
+        if (++sum->pendingBytes == 8)
+        {
+            sum->hash = checksumMix(sum->hash, sum->pending);
+            sum->pending = 0;
+            sum->pendingBytes = 0;
+        }
+    }
+    for (; len >= 8; bytes += 8, len -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        sum->hash = checksumMix(sum->hash, word);
+    }
+    while (len > 0)
+    {
+        sum->pending |= (uint64_t)*bytes++ << (8 * sum->pendingBytes);
+        sum->pendingBytes++;
+        len--;
+    }
+}
+
+uint64_t checksumFinish(Checksum *sum)
+{
+    uint64_t hash = sum->hash;
+    if (sum->pendingBytes > 0)
+    {
+        hash = checksumMix(hash, sum->pending);
+    }
+    return checksumMix(hash, (uint64_t)sum->pendingBytes);
+}
+
+// Write the list as a binary snapshot that loadbin can map straight back in,
+// forcing it to disk first when durable is set. Returns 1 on success and
+// prints the reason otherwise.
+int writeSnapshot(WordList *list, const char *filename, int durable)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        replyError("Cannot open file '%s'.\n", filename);
+        return 0;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.count = (uint64_t)wordCount(list);
+    Checksum sum;
+    checksumInit(&sum);
+
+    // The header is rewritten once the blob size and checksum are known
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t offset = 0;
+    for (int i = list->base; ok && i < list->size; i++)
+    {
+        ok = fwrite(&offset, sizeof(offset), 1, file) == 1;
+        checksumUpdate(&sum, &offset, sizeof(offset));
+        offset += strlen(wordAt(list, i)) + 1;
+    }
+    for (int i = list->base; ok && i < list->size; i++)
+    {
+        size_t len = strlen(wordAt(list, i)) + 1;
+        ok = fwrite(wordAt(list, i), 1, len, file) == len;
+        checksumUpdate(&sum, wordAt(list, i), len);
+    }
+    header.blobSize = offset;
+    list->stats.bytesWritten += sizeof(header) + header.count * sizeof(uint64_t) + offset;
+    header.checksum = checksumFinish(&sum);
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    if (durable)
+    {
+        ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    }
+    if (fclose(file) != 0 || !ok)
+    {
+        replyError("Error: Failed to write '%s'.\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+void savebin(WordList *list, const char *filename)
+{
+    char *trimmed = trim((char *)filename);
+    if (strlen(trimmed) == 0)
+    {
+        replyError("Error: Invalid filename\n");
+        return;
+    }
+    if (writeSnapshot(list, trimmed, 0))
+    {
+        reply("Saved %d words to '%s'.\n", wordCount(list), trimmed);
+    }
+}
+
+// Map a snapshot written by savebin and append its words. The words are
+// used in place, so after validation the only per-word work is storing a
+// pointer to each one. Returns 1 on success and prints the reason otherwise.
+int loadSnapshot(WordList *list, const char *trimmed)
+{
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int fd = open(trimmed, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0) close(fd);
+        replyError("Cannot open file '%s'.\n", trimmed);
+        return 0;
+    }
+    size_t length = (size_t)st.st_size;
+    char *data = length >= sizeof(SnapshotHeader)
+                     ? (char *)mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0)
+                     : (char *)MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        replyError("Error: '%s' is not a word list snapshot.\n", trimmed);
+        return 0;
+    }
+
+    const SnapshotHeader *header = (const SnapshotHeader *)data;
+    const uint64_t *offsets = (const uint64_t *)(data + sizeof(SnapshotHeader));
+    const char *blob = (const char *)(offsets + header->count);
+    const char *error = NULL;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+    {
+        error = "not a word list snapshot";
+    }
+    else if (header->version != SNAPSHOT_VERSION)
+    {
+        error = "unsupported snapshot version";
+    }
+    else if (header->count > (uint64_t)(INT32_MAX - list->size) ||
+             header->count > (length - sizeof(SnapshotHeader)) / sizeof(uint64_t) ||
+             header->blobSize != length - sizeof(SnapshotHeader) - header->count * sizeof(uint64_t) ||
+             (header->blobSize > 0 && blob[header->blobSize - 1] != 0))
+    {
+        error = "snapshot is truncated";
+    }
+    else
+    {
+        Checksum sum;
+        checksumInit(&sum);
+        checksumUpdate(&sum, offsets, header->count * sizeof(uint64_t));
+        checksumUpdate(&sum, blob, header->blobSize);
+        if (checksumFinish(&sum) != header->checksum)
+        {
+            error = "snapshot checksum mismatch";
+        }
+    }
+    for (uint64_t i = 0; !error && i < header->count; i++)
+    {
+        if (offsets[i] >= header->blobSize)
+        {
+            error = "snapshot offsets are corrupt";
+        }
+    }
+    if (error)
+    {
+        munmap(data, length);
+        replyError("Error: Cannot load '%s': %s.\n", trimmed, error);
+        return 0;
+    }
+
+    list->stats.bytesRead += length;
+    int count = (int)header->count;
+    for (int i = 0; i < count; i++)
+    {
+        appendWord(list, (char *)blob + offsets[i], 0);
+    }
+    if (list->packed.blocks)
+    {
+        munmap(data, length);
+    }
+    else
+    {
+        addMapping(list, data, length);
+    }
+    printLoadSummary(count, 0, trimmed, &start);
+    return 1;
+}
+
+void loadbin(WordList *list, const char *filename)
+{
+    char *trimmed = trim((char *)filename);
+    if (strlen(trimmed) == 0)
+    {
+        replyError("Error: Invalid filename\n");
+        return;
+    }
+    loadSnapshot(list, trimmed);
+}
+
+// Make a rename or creation in path's directory durable
+int syncDirectory(const char *path)
+{
+    char directory[4096];
+    const char *slash = strrchr(path, '/');
+    if (!slash)
+    {
+        strcpy(directory, ".");
+    }
+    else
+    {
+        size_t length = slash == path ? 1 : (size_t)(slash - path);
+        if (length >= sizeof(directory))
+        {
+            return 0;
+        }
+        memcpy(directory, path, length);
+        directory[length] = 0;
+    }
+    int fd = open(directory, O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
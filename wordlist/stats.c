@@ -0,0 +1,187 @@
+// Latency histograms and work counters, and the stats command.
+
+#include "wordlist.h"
+
+static const char *const statNames[STAT_COMMANDS] = {
+    "insert", "findfwd", "findrev", "findall", "count", "showrev", "load", "loadbin", "save", "savebin",
+    "findmulti", "findmultirev"};
+
+static int latencyBucket(uint64_t ns)
+{
+    if (ns < 4)
+    {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    return msb * 4 + (int)((ns >> (msb - 2)) & 3);
+}
+
+// Largest latency a bucket can hold
+static uint64_t latencyBucketLimit(int bucket)
+{
+    if (bucket < 4)
+    {
+        return (uint64_t)bucket;
+    }
+    int msb = bucket / 4;
+    uint64_t limit = (uint64_t)(4 + bucket % 4 + 1) << (msb - 2);
+    return limit - 1;
+}
+
+void recordLatency(WordList *list, int command, const struct timespec *start)
+{
+    if (command < 0)
+    {
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed = (int64_t)(now.tv_sec - start->tv_sec) * 1000000000 + (now.tv_nsec - start->tv_nsec);
+    uint64_t ns = elapsed > 0 ? (uint64_t)elapsed : 0;
+    LatencyStats *latency = &list->stats.commands[command];
+    latency->count++;
+    latency->totalNs += ns;
+    if (ns > latency->maxNs)
+    {
+        latency->maxNs = ns;
+    }
+    latency->buckets[latencyBucket(ns)]++;
+}
+
+// Upper bound of the bucket holding the given fraction of calls, capped at the max
+uint64_t latencyPercentile(const LatencyStats *latency, double fraction)
+{
+    if (latency->count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(fraction * latency->count + 0.5);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++)
+    {
+        seen += latency->buckets[b];
+        if (seen >= rank)
+        {
+            uint64_t limit = latencyBucketLimit(b);
+            return limit < latency->maxNs ? limit : latency->maxNs;
+        }
+    }
+    return latency->maxNs;
+}
+
+// Add the counters of from to into
+void addStats(Stats *into, const Stats *from)
+{
+    for (int i = 0; i < STAT_COMMANDS; i++)
+    {
+        LatencyStats *latency = &into->commands[i];
+        const LatencyStats *other = &from->commands[i];
+        latency->count += other->count;
+        latency->totalNs += other->totalNs;
+        if (other->maxNs > latency->maxNs)
+        {
+            latency->maxNs = other->maxNs;
+        }
+        for (int b = 0; b < STATS_BUCKETS; b++)
+        {
+            latency->buckets[b] += other->buckets[b];
+        }
+    }
+    into->finds += from->finds;
+    into->wordsScanned += from->wordsScanned;
+    into->cacheHits += from->cacheHits;
+    into->bytesRead += from->bytesRead;
+    into->bytesWritten += from->bytesWritten;
+}
+
+void printStats(const WordList *list, FILE *out, int json)
+{
+    const Stats *stats = &list->stats;
+    Stats merged;
+    if (list->server)
+    {
+        // Queries count into their clients' views, which add into the server
+        merged = list->stats;
+        pthread_mutex_lock(&list->server->statsLock);
+        addStats(&merged, &list->server->stats);
+        pthread_mutex_unlock(&list->server->statsLock);
+        stats = &merged;
+    }
+    if (json)
+    {
+        fprintf(out, "{\"words\":%d,", wordCount(list));
+        if (list->ids)
+        {
+            fprintf(out, "\"distinct\":%d,", list->intern.size);
+        }
+        fprintf(out, "\"commands\":{");
+        for (int i = 0; i < STAT_COMMANDS; i++)
+        {
+            const LatencyStats *latency = &stats->commands[i];
+            fprintf(out, "%s\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu}",
+                    i ? "," : "", statNames[i], (unsigned long long)latency->count,
+                    (unsigned long long)latency->totalNs,
+                    (unsigned long long)latencyPercentile(latency, 0.50),
+                    (unsigned long long)latencyPercentile(latency, 0.99),
+                    (unsigned long long)latency->maxNs);
+        }
+        fprintf(out, "},\"finds\":%llu,\"words_scanned\":%llu,\"cache_hits\":%llu,\"bytes_read\":%llu,\"bytes_written\":%llu}\n",
+                (unsigned long long)stats->finds, (unsigned long long)stats->wordsScanned,
+                (unsigned long long)stats->cacheHits,
+                (unsigned long long)stats->bytesRead, (unsigned long long)stats->bytesWritten);
+        return;
+    }
+    fprintf(out, "%-12s %10s %12s %12s %12s %12s\n", "command", "count", "p50 (us)", "p99 (us)", "max (us)", "total (ms)");
+    for (int i = 0; i < STAT_COMMANDS; i++)
+    {
+        const LatencyStats *latency = &stats->commands[i];
+        if (latency->count == 0)
+        {
+            continue;
+        }
+        fprintf(out, "%-12s %10llu %12.1f %12.1f %12.1f %12.1f\n", statNames[i],
+                (unsigned long long)latency->count, latencyPercentile(latency, 0.50) / 1e3,
+                latencyPercentile(latency, 0.99) / 1e3, latency->maxNs / 1e3, latency->totalNs / 1e6);
+    }
+    fprintf(out, "Words: %d, finds: %llu, words scanned: %llu (%.1f per find), cache hits: %llu\n", wordCount(list),
+            (unsigned long long)stats->finds, (unsigned long long)stats->wordsScanned,
+            stats->finds ? (double)stats->wordsScanned / stats->finds : 0.0,
+            (unsigned long long)stats->cacheHits);
+    fprintf(out, "Bytes read: %llu, bytes written: %llu\n",
+            (unsigned long long)stats->bytesRead, (unsigned long long)stats->bytesWritten);
+    if (list->ids)
+    {
+        fprintf(out, "Distinct words: %d\n", list->intern.size);
+    }
+}
+
+void statsCommand(WordList *list, const char *arg)
+{
+    if (*arg == 0)
+    {
+        printStats(list, replyFile(), 0);
+    }
+    else if (strcmp(arg, "json") == 0)
+    {
+        printStats(list, replyFile(), 1);
+    }
+    else if (strcmp(arg, "reset") == 0)
+    {
+        memset(&list->stats, 0, sizeof(list->stats));
+        if (list->server)
+        {
+            pthread_mutex_lock(&list->server->statsLock);
+            memset(&list->server->stats, 0, sizeof(list->server->stats));
+            pthread_mutex_unlock(&list->server->statsLock);
+        }
+        reply("Statistics reset.\n");
+    }
+    else
+    {
+        replyError("Error: Invalid stats option '%s' (expected json/reset)\n", arg);
+    }
+}
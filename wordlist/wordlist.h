@@ -0,0 +1,881 @@
+// Internal header of more, whose main() is in more.c. The rest of the
+// program is split by subsystem into the files of this directory:
+//
+//   list.c      slots, segments and the arena; adding words; threads and the
+//               streaming window
+//   fold.c      case folding, UTF-8 and word signatures
+//   index.c     the trigram substring index
+//   intern.c    interning
+//   packed.c    compression
+//   find.c      findfwd, findrev, findall and count
+//   cache.c     the pattern cache
+//   multi.c     findmulti and findmultirev
+//   order.c     showrev
+//   load.c      load and save
+//   snapshot.c  savebin and loadbin
+//   journal.c   the journal and compact
+//   stats.c     stats
+//   commands.c  command output, the command table and dispatch
+//   server.c    serving clients on a socket
+//
+// This header has the constants and types they share, the prototypes of
+// their functions and the inline slot accessors and scans the finds are
+// built from.
+#ifndef WORDLIST_H
+#define WORDLIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../casesearch.h"
+
+#define MAX_WORD_LEN 256
+#define INITIAL_CAPACITY 10
+#define SEGMENT_BITS 10
+#define SEGMENT_SIZE (1 << SEGMENT_BITS)
+#define MAX_SEGMENTS 22
+#define ARENA_CHUNK_SIZE (1 << 20)
+#define TRIGRAM_BUCKETS (1 << 16)
+#define MAX_THREADS 64
+#define PARALLEL_MIN_WORDS 65536
+#define SNAPSHOT_MAGIC "WLSNAP\0\0"
+#define SNAPSHOT_VERSION 1
+#define OUTPUT_BUFFER_SIZE (1 << 24)
+#define STATS_BUCKETS 256
+#define BATCH_BUFFER_SIZE (1 << 20)
+#define PATTERN_CACHE_SLOTS 64
+#define PATTERN_CACHE_MATCHES 4096
+#define MATCHER_CACHE_SLOTS 8
+#define FOLD_BUFFER_SIZE (2 * MAX_WORD_LEN + 1)
+#define PACK_BLOCK_BITS 5
+#define PACK_BLOCK_WORDS (1 << PACK_BLOCK_BITS)
+#define PACK_DECODE_SLOTS 4
+#define LOAD_BLOCK_SIZE (1 << 23)
+#define JOURNAL_MAGIC "WLJRNL\0\0"
+#define JOURNAL_BUFFER_SIZE (1 << 16)
+#define JOURNAL_SYNC_MS 1000
+#define MAX_WINDOW (1 << 24)
+#define WINDOW_REBASE_AT (1 << 30)
+#define MAX_CLIENTS 64
+#define MAX_LINE_LEN 1024
+
+// lastId bounds the ids of the words stored in the chunk; it is INT32_MAX
+// while words may still be added to it
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *next;
+    size_t used;
+    size_t capacity;
+    int lastId;
+} ArenaChunk;
+
+// A file mapped into memory whose bytes back some of the words
+typedef struct Mapping
+{
+    struct Mapping *next;
+    void *addr;
+    size_t length;
+} Mapping;
+
+// Binary snapshot layout (native byte order): this header, then count
+// uint64_t offsets into the blob, then the blob of NUL-terminated words.
+// The checksum covers the offsets table and the blob.
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t blobSize;
+    uint64_t checksum;
+} SnapshotHeader;
+
+// Journal log layout: this header, then one record per appended word, each
+// a uint32_t length, the low 32 bits of the word's checksum and the word's
+// bytes. `base` is the snapshot word count the records follow on from.
+typedef struct
+{
+    char magic[8];
+    uint64_t base;
+} JournalHeader;
+
+typedef enum
+{
+    SYNC_ALWAYS,
+    SYNC_PERIODIC,
+    SYNC_NONE
+} SyncPolicy;
+
+// Write-ahead log of appended words. Records collect in `buffer` and are
+// written (and synced, as the policy says) together at commit points.
+typedef struct
+{
+    int fd;
+    char *path;
+    SyncPolicy policy;
+    char *buffer;
+    size_t used;
+    struct timespec lastSync;
+} Journal;
+
+// Streaming 64-bit checksum that consumes input eight bytes at a time
+typedef struct
+{
+    uint64_t hash;
+    uint64_t pending;
+    int pendingBytes;
+} Checksum;
+
+typedef struct
+{
+    int *ids;
+    int size;
+    int capacity;
+} PostingList;
+
+// Treap node for one of the last `window` words. Nodes live in a ring
+// indexed by word id modulo the window, so the word that falls out of the
+// window frees exactly the slot the newest word needs.
+typedef struct OrderNode
+{
+    struct OrderNode *left;
+    struct OrderNode *right;
+    unsigned priority;
+    int id;
+} OrderNode;
+
+// The last `window` words (as of list size `upto`) kept in showrev order
+typedef struct
+{
+    OrderNode *root;
+    OrderNode *nodes;
+    int window;
+    int upto;
+    unsigned seed;
+} ShowrevOrder;
+
+// Matches of one case-folded pattern: matches holds those among the words
+// [base, scanned) in index order, filled by forward queries, and tail those
+// among [tailFrom, tailTo) from the back, filled by reverse queries. Words
+// are only ever appended, so an entry never goes stale: it is brought up to
+// date by checking just the words added since it was filled. An entry holds
+// at most PATTERN_CACHE_MATCHES matches; queries that need more scan the
+// words past them without storing.
+typedef struct
+{
+    char *pattern;
+    int *matches;
+    int size;
+    int capacity;
+    int scanned;
+    int *tail;
+    int tailSize;
+    int tailCapacity;
+    int tailFrom;
+    int tailTo;
+    uint64_t lastUsed;
+} PatternEntry;
+
+// Least recently used entries are reused once all slots are taken
+typedef struct
+{
+    PatternEntry *entries;
+    uint64_t clock;
+} PatternCache;
+
+// Code points first, first + stride, ..., last fold to code point + delta
+typedef struct
+{
+    uint32_t first;
+    uint32_t last;
+    int32_t delta;
+    int32_t stride;
+} CaseRange;
+
+// A case-insensitive Aho-Corasick automaton for a set of patterns. Bytes
+// are mapped to classes first (class 0 for bytes no pattern contains), so
+// the transition table next has only width = classes + 1 entries a state.
+// A pattern is identified by the state ending it (ends[p] for the pth
+// pattern), so patterns equal but for case share one. hit[s] is the
+// nearest state ending a pattern on the suffix chain of s, itself included,
+// or -1; the patterns a state completes are hit[s], hit[fail[hit[s]]] and
+// so on.
+typedef struct
+{
+    char *key;
+    int patterns;
+    int states;
+    int width;
+    unsigned char classOf[256];
+    int *next;
+    int *fail;
+    int *hit;
+    int *ends;
+    uint64_t lastUsed;
+} Matcher;
+
+// Compiled findmulti pattern sets, keyed by their case-folded text
+typedef struct
+{
+    Matcher *entries;
+    uint64_t clock;
+} MatcherCache;
+
+// The distinct words of an interned list, which the list's words and keys
+// then hold by distinct id. slots is an open-addressing hash table of
+// hash << 32 | distinct id + 1 (0 for a free slot), so most probes are
+// settled without touching the words; counts holds how often each word
+// occurs. memo caches whether each word matched the current find's pattern,
+// as epoch << 1 | matched.
+typedef struct
+{
+    uint64_t *slots;
+    int *counts;
+    uint32_t *memo;
+    uint32_t epoch;
+    int slotMask;
+    int size;
+    int capacity;
+} InternTable;
+
+// PACK_BLOCK_WORDS consecutive words of a compressed list, front coded: each
+// word is a header byte, the bytes it shares with the word before it in the
+// high nibble and the length of the rest in the low one (a high nibble of
+// 15 means both follow as varints instead), then the rest. textLength is
+// the room the decoded words and their folds can take. mask has the
+// wordSignature() bits of all the folded words, so a pattern with a byte
+// missing from it, or longer than its words, passes the block over undecoded.
+typedef struct
+{
+    unsigned char *data;
+    size_t length;
+    size_t textLength;
+    uint64_t mask;
+} PackedBlock;
+
+// The size words of a compressed list (a word is packed before the list's
+// size covers it), in blocks of which the last one is filled in `open` and
+// moved into the arena once full. last is a copy of the last word added,
+// for its successor's shared prefix. generation tells apart the blocks that
+// threads decoded for different lists.
+typedef struct
+{
+    PackedBlock *blocks;
+    int size;
+    int count;
+    int capacity;
+    unsigned char *open;
+    size_t openCapacity;
+    char *last;
+    size_t lastCapacity;
+    uint64_t generation;
+} PackedStore;
+
+// A block that a thread decoded: its words and their folds (the word itself
+// when folding leaves it unchanged), held in text
+typedef struct
+{
+    uint64_t generation;
+    uint64_t used;
+    int block;
+    int words;
+    char *text;
+    size_t capacity;
+    const char *word[PACK_BLOCK_WORDS];
+    const char *fold[PACK_BLOCK_WORDS];
+} DecodedBlock;
+
+typedef enum
+{
+    STAT_INSERT,
+    STAT_FINDFWD,
+    STAT_FINDREV,
+    STAT_FINDALL,
+    STAT_COUNT,
+    STAT_SHOWREV,
+    STAT_LOAD,
+    STAT_LOADBIN,
+    STAT_SAVE,
+    STAT_SAVEBIN,
+    STAT_FINDMULTI,
+    STAT_FINDMULTIREV,
+    STAT_COMMANDS
+} StatCommand;
+
+// Latency histogram with four buckets per power of two nanoseconds
+typedef struct
+{
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    uint64_t buckets[STATS_BUCKETS];
+} LatencyStats;
+
+// Counters updated inline by the command loop and the operations; they
+// are plain fields so recording costs a few adds and no allocation
+typedef struct
+{
+    LatencyStats commands[STAT_COMMANDS];
+    uint64_t finds;
+    uint64_t wordsScanned;
+    uint64_t cacheHits;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+} Stats;
+
+// How the dispatcher splits a command's arguments before calling it
+typedef enum
+{
+    ARGS_NONE,
+    ARGS_TEXT,
+    ARGS_OPTIONAL_TEXT,
+    ARGS_PATTERN,
+    ARGS_PATTERN_COUNT,
+    ARGS_PATTERN_RANGE,
+    ARGS_COUNT,
+    ARGS_COUNT_PATTERNS
+} ArgsKind;
+
+struct Server;
+
+// Word ids count every word ever appended. Words, their case-folded forms
+// (folds, the word itself when folding leaves it unchanged) and sort keys
+// are kept in slots, spread over `segments` blocks that are added as the
+// list grows and never moved. Normally word id is in slot id, all of [0, size) are kept
+// and mask is -1. In streaming mode (window > 0) the slots are a ring of
+// mask + 1 slots, a power of two, with word id in slot id & mask; only the
+// last `window` words, [base, size), are visible, and the ring holds at
+// least twice that so a showrev catching up can still compare the words it
+// removes. An interned list keeps each distinct word once, in slot
+// distinct id, and ids (capacity entries) maps word id to distinct id. A
+// compressed list keeps no slots and holds its words in packed instead.
+// Each slot also has the wordSignature() of its fold, kept apart in
+// signatures so a scan can test many of them before reading any word; need
+// is the signature of the current find's pattern. A list being served
+// publishes size, threads, the substring index and whether it caches
+// patterns atomically for the server's readers.
+typedef struct {
+    char **words[MAX_SEGMENTS];
+    char **folds[MAX_SEGMENTS];
+    uint64_t *keys[MAX_SEGMENTS];
+    uint64_t *signatures[MAX_SEGMENTS];
+    int segments;
+    uint32_t *ids;
+    int size;
+    int capacity;
+    int base;
+    int window;
+    int mask;
+    InternTable intern;
+    PackedStore packed;
+    uint64_t need;
+    struct Server *server;
+    ArenaChunk *chunks;
+    Mapping *mappings;
+    PostingList *trigrams;
+    int threads;
+    int quiet;
+    ShowrevOrder order;
+    PatternCache cache;
+    MatcherCache matchers;
+    Journal journal;
+    Stats stats;
+} WordList;
+
+typedef struct
+{
+    const char *name;
+    ArgsKind args;
+    int stat;
+    int query;
+    void (*withText)(WordList *list, const char *text);
+    void (*withPatternCount)(WordList *list, const char *pattern, int n);
+    void (*withCount)(WordList *list, int n);
+    void (*withPatternRange)(WordList *list, const char *pattern, int limit, int offset);
+} Command;
+
+typedef struct
+{
+    const WordList *list;
+    const char *pattern;
+    int begin;
+    int end;
+    int count;
+    int *matches;
+    int capacity;
+} ScanChunk;
+
+// The words of [begin, end) that may contain the current find's pattern,
+// walked from the front (or the back when reverse is set). bits holds the
+// candidates among the 64 words from `at` not handed out yet.
+typedef struct
+{
+    const WordList *list;
+    int begin;
+    int end;
+    int reverse;
+    int at;
+    uint64_t bits;
+} CandidateScan;
+
+// The words of [begin, end) that contain a pattern, walked like a
+// CandidateScan, or through the index's posting list when it has one for
+// the pattern; ids is that list's array as read when the scan began. Every
+// word between the range's starting side and frontier has been checked.
+typedef struct
+{
+    const WordList *list;
+    const char *pattern;
+    const PostingList *candidates;
+    const int *ids;
+    int lo;
+    int hi;
+    int checked;
+    int reverse;
+    int begin;
+    int end;
+    int frontier;
+    CandidateScan scan;
+} MatchScan;
+
+// A connected client and the view its queries run on
+typedef struct
+{
+    struct Server *server;
+    pthread_t thread;
+    int fd;
+    int active;
+    int finished;
+    WordList view;
+} ServerClient;
+
+// Queries run concurrently on each client's thread against its view of the
+// list; every other command takes writeLock, so one writer at a time
+// changes the list. Segments are never moved or freed while serving, so a
+// view stays valid with no reclamation; posting lists of the substring
+// index are copied rather than moved as they grow, and the arrays they
+// leave behind are kept in retired until the server stops. showrev shares
+// the list's order under orderLock, and the views add their counters into
+// stats under statsLock after every line.
+typedef struct Server
+{
+    WordList *list;
+    int fd;
+    pthread_mutex_t writeLock;
+    pthread_mutex_t orderLock;
+    pthread_mutex_t statsLock;
+    Stats stats;
+    int **retired;
+    int retiredSize;
+    int retiredCapacity;
+    ServerClient clients[MAX_CLIENTS];
+} Server;
+
+// commands.c
+extern __thread FILE *replyStream;
+extern int quietErrors;
+// fold.c
+extern uint64_t (*signatureKernel)(const uint64_t *, int, uint64_t);
+
+// list.c
+char *trim(char *str);
+void initWordList(WordList *list);
+void reserveSlots(WordList *list, uint32_t slots);
+void resizeWordList(WordList *list);
+void freeWordList(WordList *list);
+char *arenaAlloc(WordList *list, size_t len);
+char *arenaStrdup(WordList *list, const char *str);
+void releaseChunks(WordList *list);
+void storeWord(WordList *list, uint32_t slot, char *word, int copy);
+int isAlphanumeric(const char *str);
+int validateWord(const char *word, int report);
+int addWord(WordList *list, char *word, int copy, int report);
+void appendWord(WordList *list, char *word, int copy);
+void insert(WordList *list, const char *word);
+void setThreads(WordList *list, const char *arg);
+void setWindow(WordList *list, const char *arg);
+void rebaseWindow(WordList *list);
+
+// fold.c
+int strcasecmp(const char *s1, const char *s2);
+char *strcasestr(const char *haystack, const char *needle);
+uint64_t signaturesScalar(const uint64_t *signatures, int n, uint64_t need);
+#ifdef WORDLIST_X86_SIMD
+uint64_t signaturesSse2(const uint64_t *signatures, int n, uint64_t need);
+uint64_t signaturesAvx2(const uint64_t *signatures, int n, uint64_t need);
+#endif
+uint32_t foldCodepoint(uint32_t cp);
+size_t foldText(const char *text, size_t len, char *out, int *changed);
+char *foldPattern(const char *pattern, char *buffer);
+uint64_t wordSignature(const char *folded);
+uint64_t candidateBits(const WordList *list, int from, int n);
+
+// index.c
+unsigned trigramBucket(const char *str);
+void indexWord(WordList *list, PostingList *trigrams, int id);
+void buildIndex(WordList *list);
+void freeIndex(WordList *list);
+const PostingList *indexCandidates(const WordList *list, const char *pattern);
+void setIndex(WordList *list, const char *mode);
+
+// intern.c
+uint32_t hashWord(const char *word);
+uint32_t internWord(WordList *list, char *word, int copy);
+void freeIntern(WordList *list);
+void enableIntern(WordList *list);
+void setIntern(WordList *list, const char *mode);
+
+// packed.c
+void packWord(WordList *list, const char *word);
+const DecodedBlock *decodeBlock(const WordList *list, int block);
+int packedMatches(const WordList *list, int id, const char *pattern);
+void freePacked(WordList *list);
+void enablePacked(WordList *list);
+void setCompress(WordList *list, const char *mode);
+
+// find.c
+int countMatches(const WordList *list, const char *pattern, int begin, int end);
+int nthMatchInRange(const WordList *list, const char *pattern, int begin, int end, int n, int reverse);
+void runChunks(void *chunks, size_t chunkSize, int threads, void *(*worker)(void *));
+void beginMatch(WordList *list, const char *pattern);
+void matchDistinct(WordList *list, const char *pattern);
+int findNthParallel(WordList *list, const char *pattern, int begin, int end, int n, int reverse, int *total);
+int findNthInRange(WordList *list, const char *pattern, int begin, int end, int n, int reverse, int *total);
+void addMatch(int **matches, int *size, int *capacity, int id);
+void *collectChunk(void *arg);
+int findNthFolded(WordList *list, const char *pattern, int n, int reverse);
+int findNth(WordList *list, const char *pattern, int n, int reverse);
+void findfwd(WordList *list, const char *pattern, int n);
+void findrev(WordList *list, const char *pattern, int n);
+int scanFolded(WordList *list, const char *pattern, int offset, int limit, int print);
+int scanMatches(WordList *list, const char *pattern, int offset, int limit, int print);
+void findall(WordList *list, const char *pattern, int limit, int offset);
+void count(WordList *list, const char *pattern);
+
+// cache.c
+void enableCache(WordList *list);
+void freeCache(WordList *list);
+PatternEntry *lookupPattern(WordList *list, const char *pattern);
+void extendPattern(WordList *list, PatternEntry *entry, const char *pattern, int want);
+int findNthCached(WordList *list, const char *pattern, int n, int reverse);
+void setCache(WordList *list, const char *mode);
+
+// multi.c
+void buildMatcher(Matcher *matcher, char **patterns, int count);
+Matcher *lookupMatcher(WordList *list, const char *key, char **patterns, int count);
+void freeMatchers(WordList *list);
+int scanMulti(const WordList *list, const Matcher *matcher, int begin, int end, int reverse, const int *want, int *counts, int *seen, int *found, int pending);
+void findMulti(WordList *list, const Matcher *matcher, int n, int reverse, int *found);
+void findmulti(WordList *list, const char *patterns, int n);
+void findmultirev(WordList *list, const char *patterns, int n);
+
+// order.c
+uint64_t sortKey(const char *word);
+int orderBefore(const WordList *list, int a, int b);
+void sortOrder(const WordList *list, int *ids, uint64_t *keys, int n, size_t depth, int *idScratch, uint64_t *keyScratch);
+OrderNode *buildOrder(const WordList *list, OrderNode *nodes, const int *ids, int n);
+OrderNode *orderInsert(const WordList *list, OrderNode *root, OrderNode *node);
+OrderNode *orderRemove(const WordList *list, OrderNode *root, int id);
+void syncShowrevOrder(WordList *list, int window);
+void showrev(WordList *list, int n);
+
+// load.c
+void load(WordList *list, const char *filename);
+int loadParallel(WordList *list, int fd, int *rejected);
+void save(WordList *list, const char *filename);
+double elapsedMs(const struct timespec *start);
+void printLoadSummary(int loaded, int rejected, const char *filename, const struct timespec *start);
+
+// snapshot.c
+void addMapping(WordList *list, void *addr, size_t length);
+void checksumInit(Checksum *sum);
+void checksumUpdate(Checksum *sum, const void *data, size_t len);
+uint64_t checksumFinish(Checksum *sum);
+int writeSnapshot(WordList *list, const char *filename, int durable);
+void savebin(WordList *list, const char *filename);
+int loadSnapshot(WordList *list, const char *filename);
+void loadbin(WordList *list, const char *filename);
+int syncDirectory(const char *path);
+
+// journal.c
+uint32_t recordChecksum(const char *word, uint32_t length);
+void journalAppend(WordList *list, const char *word);
+int journalWrite(WordList *list, const char *data, size_t length);
+void journalCommit(WordList *list);
+int journalReplay(WordList *list, const char *logPath);
+int journalReset(WordList *list);
+void openJournal(WordList *list, const char *path, SyncPolicy policy);
+void closeJournal(WordList *list);
+void journal(WordList *list, const char *arg);
+void compact(WordList *list, const char *arg);
+
+// stats.c
+void recordLatency(WordList *list, int command, const struct timespec *start);
+uint64_t latencyPercentile(const LatencyStats *latency, double fraction);
+void addStats(Stats *into, const Stats *from);
+void printStats(const WordList *list, FILE *out, int json);
+void statsCommand(WordList *list, const char *arg);
+
+// commands.c
+FILE *replyFile(void);
+void reply(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void replyError(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void printGuidance();
+void setQuiet(WordList *list, const char *mode);
+const Command *lookupCommand(const char *name, size_t len);
+const char *parseLeadingCount(const char *text, int *n);
+int parseCount(const char *text, int *n);
+int parseCountToken(const char *text, const char *end, int *n);
+int dispatchLine(WordList *list, char *line);
+int runBatch(WordList *list, const char *path);
+
+// server.c
+int runServer(WordList *list, const char *path);
+
+// Slot s of words and keys is in segment segmentOf(s), which starts at slot
+// segmentStart(segment). Segment 0 holds SEGMENT_SIZE slots and every later
+// one as many as all before it.
+static inline int segmentOf(uint32_t slot)
+{
+    uint32_t high = slot >> SEGMENT_BITS;
+    return high ? 32 - __builtin_clz(high) : 0;
+}
+
+static inline uint32_t segmentStart(int segment)
+{
+    return segment ? (uint32_t)SEGMENT_SIZE << (segment - 1) : 0;
+}
+
+static inline char **wordSlot(const WordList *list, uint32_t slot)
+{
+    int segment = segmentOf(slot);
+    return &list->words[segment][slot - segmentStart(segment)];
+}
+
+static inline char **foldSlot(const WordList *list, uint32_t slot)
+{
+    int segment = segmentOf(slot);
+    return &list->folds[segment][slot - segmentStart(segment)];
+}
+
+static inline uint64_t *keySlot(const WordList *list, uint32_t slot)
+{
+    int segment = segmentOf(slot);
+    return &list->keys[segment][slot - segmentStart(segment)];
+}
+
+static inline uint64_t *signatureSlot(const WordList *list, uint32_t slot)
+{
+    int segment = segmentOf(slot);
+    return &list->signatures[segment][slot - segmentStart(segment)];
+}
+
+// The slot holding word id
+static inline uint32_t slotOf(const WordList *list, int id)
+{
+    return list->ids ? list->ids[id] : (uint32_t)(id & list->mask);
+}
+
+// A compressed list's words are decoded a block at a time; the text stays
+// valid until the calling thread has decoded PACK_DECODE_SLOTS other blocks
+static inline char *wordAt(const WordList *list, int id)
+{
+    if (list->packed.blocks)
+    {
+        return (char *)decodeBlock(list, id >> PACK_BLOCK_BITS)->word[id & (PACK_BLOCK_WORDS - 1)];
+    }
+    return *wordSlot(list, slotOf(list, id));
+}
+
+static inline const char *foldAt(const WordList *list, int id)
+{
+    if (list->packed.blocks)
+    {
+        return decodeBlock(list, id >> PACK_BLOCK_BITS)->fold[id & (PACK_BLOCK_WORDS - 1)];
+    }
+    return *foldSlot(list, slotOf(list, id));
+}
+
+static inline uint64_t keyAt(const WordList *list, int id)
+{
+    if (list->packed.blocks)
+    {
+        return sortKey(foldAt(list, id));
+    }
+    return *keySlot(list, slotOf(list, id));
+}
+
+// Whether word id contains the (folded) pattern of the current find. Words
+// whose signature lacks a bit of the pattern's are rejected unread; an
+// interned word is tested once per find however often it occurs.
+static inline int wordMatches(const WordList *list, int id, const char *pattern)
+{
+    if (list->packed.blocks)
+    {
+        return packedMatches(list, id, pattern);
+    }
+    if (!list->ids)
+    {
+        uint32_t slot = (uint32_t)(id & list->mask);
+        return (*signatureSlot(list, slot) & list->need) == list->need &&
+               strcasestr(*foldSlot(list, slot), pattern) != NULL;
+    }
+    uint32_t distinct = list->ids[id];
+    uint32_t memo = list->intern.memo[distinct];
+    if (memo >> 1 == list->intern.epoch)
+    {
+        return memo & 1;
+    }
+    int matched = (*signatureSlot(list, distinct) & list->need) == list->need &&
+                  strcasestr(*foldSlot(list, distinct), pattern) != NULL;
+    list->intern.memo[distinct] = list->intern.epoch << 1 | matched;
+    return matched;
+}
+
+// The number of visible words
+static inline int wordCount(const WordList *list)
+{
+    return list->size - list->base;
+}
+
+static inline void beginCandidates(CandidateScan *scan, const WordList *list, int begin, int end, int reverse)
+{
+    scan->list = list;
+    scan->begin = begin;
+    scan->end = end;
+    scan->reverse = reverse;
+    scan->bits = 0;
+}
+
+// The next candidate word, or -1 when there is none left. Their signatures
+// are tested 64 at a time.
+static inline int nextCandidate(CandidateScan *scan)
+{
+    while (!scan->bits)
+    {
+        int n = scan->end - scan->begin < 64 ? scan->end - scan->begin : 64;
+        if (n <= 0)
+        {
+            return -1;
+        }
+        if (scan->reverse)
+        {
+            scan->end -= n;
+            scan->at = scan->end;
+        }
+        else
+        {
+            scan->at = scan->begin;
+            scan->begin += n;
+        }
+        scan->bits = candidateBits(scan->list, scan->at, n);
+    }
+    if (scan->reverse)
+    {
+        int k = 63 - __builtin_clzll(scan->bits);
+        scan->bits &= ~(1ull << k);
+        return scan->at + k;
+    }
+    int k = __builtin_ctzll(scan->bits);
+    scan->bits &= scan->bits - 1;
+    return scan->at + k;
+}
+
+// The position of the first id >= id among the size ids of a posting list
+static inline int firstPosting(const int *ids, int size, int id)
+{
+    int lo = 0, hi = size;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (ids[mid] < id) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static inline void beginMatches(MatchScan *scan, const WordList *list, const char *pattern, int begin, int end, int reverse)
+{
+    const PostingList *posting = indexCandidates(list, pattern);
+    scan->list = list;
+    scan->pattern = pattern;
+    scan->candidates = posting;
+    scan->ids = NULL;
+    scan->checked = 0;
+    scan->reverse = reverse;
+    scan->begin = begin;
+    scan->end = end;
+    scan->frontier = reverse ? end : begin;
+    scan->lo = scan->hi = 0;
+    beginCandidates(&scan->scan, list, begin, end, reverse);
+    if (posting)
+    {
+        // The writer may be appending to the list while serving; the size
+        // read first is covered by the ids array read after it
+        int size = __atomic_load_n(&posting->size, __ATOMIC_ACQUIRE);
+        scan->ids = __atomic_load_n(&posting->ids, __ATOMIC_ACQUIRE);
+        scan->lo = firstPosting(scan->ids, size, begin);
+        scan->hi = firstPosting(scan->ids, size, end);
+    }
+}
+
+// The next word containing the pattern, or -1 when there is none left
+static inline int nextMatch(MatchScan *scan)
+{
+    for (;;)
+    {
+        int i;
+        if (scan->candidates)
+        {
+            if (scan->lo >= scan->hi)
+            {
+                i = -1;
+            }
+            else
+            {
+                i = scan->ids[scan->reverse ? --scan->hi : scan->lo++];
+                scan->checked++;
+            }
+        }
+        else
+        {
+            i = nextCandidate(&scan->scan);
+        }
+        if (i < 0)
+        {
+            scan->frontier = scan->reverse ? scan->begin : scan->end;
+            return -1;
+        }
+        if (wordMatches(scan->list, i, scan->pattern))
+        {
+            scan->frontier = scan->reverse ? i : i + 1;
+            return i;
+        }
+    }
+}
+
+// The work a MatchScan has done: candidates checked, or words passed
+static inline int matchScanWork(const MatchScan *scan)
+{
+    if (scan->candidates)
+    {
+        return scan->checked;
+    }
+    return scan->reverse ? scan->end - scan->frontier : scan->frontier - scan->begin;
+}
+
+#endif